@@ -5,11 +5,31 @@
 
 #include <cerrno>
 #include <memory.h>
+#include <sys/ioctl.h>
 #include <sys/uio.h>
 
 using namespace muduo;
 
+const size_t Buffer::kWarmReadSize;
+const size_t Buffer::kMaxAdaptiveRead;
+
 ssize_t Buffer::readfd(int fd,int* savedErrno){
+  int avail = 0;
+  if(readHint_ >= kWarmReadSize && ::ioctl(fd,FIONREAD,&avail) == 0 && avail > 0) {
+    //大流量连接：按最近的读取量预留空间，FIONREAD 显示有更多数据时一次留够
+    const size_t want = std::max(readHint_,static_cast<size_t>(avail));
+    ensureWritableBytes(std::min(want,kMaxAdaptiveRead));
+    const ssize_t n = ::read(fd,beginWrite(),writableBytes());
+    if(n<0) {
+      *savedErrno = errno;
+    }else {
+      writeIndex += n;
+      updateReadHint(static_cast<size_t>(n));
+    }
+    return n;
+  }
+
+  //冷连接，或者没有待读数据(EOF、EAGAIN)：不为这次读取预留空间，用栈上的 extrabuf 兜底
   char extrabuf[65536];
   struct iovec vec[2];
   const size_t writable = writableBytes();
@@ -22,9 +42,11 @@ ssize_t Buffer::readfd(int fd,int* savedErrno){
     *savedErrno = errno;
   }else if(n<=writable) {
     writeIndex += n;
+    updateReadHint(static_cast<size_t>(n));
   }else {
-    writeIndex = buffer_.size();
+    writeIndex = capacity_;
     append(extrabuf,n-writable);
+    updateReadHint(static_cast<size_t>(n));
   }
   return n;
 }
\ No newline at end of file
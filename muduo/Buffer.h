@@ -4,11 +4,15 @@
 #define BUFFER_H
 #include <algorithm>
 #include <string>
-#include <vector>
 #include <cassert>
+#include <cstring>
 
 #include <unistd.h>
 
+#include "BufferPool.h"
+#include "ByteSearch.h"
+#include "SocketsOps.h"
+
 
 namespace muduo {
 /// A buffer class modeled after org.jboss.netty.buffer.ChannelBuffer
@@ -21,14 +25,68 @@ namespace muduo {
 /// |                   |                  |                  |
 /// 0      <=      readerIndex   <=   writerIndex    <=     size
 /// @endcode
+///
+/// 用 Buffer(BufferPool*) 构造的缓冲区一开始不占内存，需要时从池里借，
+/// 数据被全部取走时立即还回去，空闲连接因此不占输入缓冲区。
+/// 这样的缓冲区只能在池所属的循环线程中使用
 class Buffer {
 public:
   static const size_t kCheapPrepend = 8; //初始化预留空间 prependable
   static const size_t kInitialSize = 1024;//writeable
+  //最近的读取量达到这个值后视为大流量连接，readfd 直接在缓冲区内预留空间，不再经过栈上的 extrabuf
+  static const size_t kWarmReadSize = 16 * 1024;
+  //自适应读取一次最多预留的空间
+  static const size_t kMaxAdaptiveRead = 1024 * 1024;
+  //扩容时容量翻倍，但一次最多多分配这么多
+  static const size_t kDefaultMaxGrowth = 4 * 1024 * 1024;
 
   Buffer():
-  buffer_(kCheapPrepend+kInitialSize),readIndex(kCheapPrepend),writeIndex(kInitialSize) {
+  buffer_(new char[kCheapPrepend+kInitialSize]()),capacity_(kCheapPrepend+kInitialSize),
+  readIndex(kCheapPrepend),writeIndex(kCheapPrepend),readHint_(0),
+  maxGrowth_(kDefaultMaxGrowth),pool_(nullptr) {
+
+  }
+
+  explicit Buffer(BufferPool* pool):
+  buffer_(nullptr),capacity_(0),readIndex(0),writeIndex(0),readHint_(0),
+  maxGrowth_(kDefaultMaxGrowth),pool_(pool) {
+
+  }
+
+  //副本不使用池：它可能在别的线程中使用
+  Buffer(const Buffer& rhs):
+  buffer_(nullptr),capacity_(0),readIndex(0),writeIndex(0),readHint_(rhs.readHint_),
+  maxGrowth_(rhs.maxGrowth_),pool_(nullptr) {
+    append(rhs.peek(),rhs.readableBytes());
+  }
+
+  Buffer(Buffer&& rhs) noexcept:
+  buffer_(rhs.buffer_),capacity_(rhs.capacity_),readIndex(rhs.readIndex),
+  writeIndex(rhs.writeIndex),readHint_(rhs.readHint_),maxGrowth_(rhs.maxGrowth_),pool_(rhs.pool_) {
+    rhs.buffer_ = nullptr;
+    rhs.capacity_ = 0;
+    rhs.readIndex = 0;
+    rhs.writeIndex = 0;
+  }
+
+  Buffer& operator=(Buffer rhs) noexcept {
+    swap(rhs);
+    return *this;
+  }
+
+  //析构可能发生在任意线程，池所属的循环甚至已经不在了，所以不归还给 pool_
+  ~Buffer() {
+    delete[] buffer_;
+  }
 
+  void swap(Buffer& rhs) noexcept {
+    std::swap(buffer_,rhs.buffer_);
+    std::swap(capacity_,rhs.capacity_);
+    std::swap(readIndex,rhs.readIndex);
+    std::swap(writeIndex,rhs.writeIndex);
+    std::swap(readHint_,rhs.readHint_);
+    std::swap(maxGrowth_,rhs.maxGrowth_);
+    std::swap(pool_,rhs.pool_);
   }
 
   void swap_demo(Buffer& rhs) {
@@ -41,7 +99,7 @@ public:
   }
 
   size_t writableBytes() const {
-    return buffer_.size() - writeIndex;
+    return capacity_ - writeIndex;
   }
 
   size_t prependableBytes() const {
@@ -63,7 +121,32 @@ public:
 
   void retrieve(size_t len) {
     assert(len <= readableBytes());
-    readIndex += len;
+    if(len < readableBytes()) {
+      readIndex += len;
+    }else {
+      retrieveAll();
+    }
+  }
+
+  //在可读数据中从第 from 个字节开始查找，找不到返回 nullptr。
+  //增量解析时把上次已经扫描过的长度作为 from 传入，不必从头再扫；
+  //findCRLF 没找到时最后一个字节可能是 '\r'，下次应从 readableBytes()-1 开始
+  const char* find(char c,size_t from = 0) const {
+    if(from >= readableBytes()) {
+      return nullptr;
+    }
+    return ByteSearch::findByte(peek()+from,beginWrite(),c);
+  }
+
+  const char* findCRLF(size_t from = 0) const {
+    if(from >= readableBytes()) {
+      return nullptr;
+    }
+    return ByteSearch::findCRLF(peek()+from,beginWrite());
+  }
+
+  const char* findEOL(size_t from = 0) const {
+    return find('\n',from);
   }
 
   void retrieveUntil(const char* end) {
@@ -72,6 +155,12 @@ public:
   }
 
   void retrieveAll() {
+    //没有内存的缓冲区(还给池的、复制或移动走的空缓冲区)下标保持为 0，不能指向不存在的预留区
+    if(buffer_ == nullptr) {
+      readIndex = 0;
+      writeIndex = 0;
+      return;
+    }
     //全部数据读完，两个指针需要返回原位以备新一轮使用
     readIndex = kCheapPrepend;
     writeIndex = kCheapPrepend;
@@ -94,6 +183,83 @@ public:
     hasWritten(len);
   }
 
+  void append(const void* data,size_t len) {
+    append(static_cast<const char*>(data),len);
+  }
+
+  //按网络字节序追加整数。memcpy 编译后就是一次不对齐写，不要求对齐
+  void appendInt64(int64_t x) {
+    int64_t be64 = sockets::hostToNetwork64(x);
+    append(&be64,sizeof be64);
+  }
+
+  void appendInt32(int32_t x) {
+    int32_t be32 = sockets::hostToNetwork32(x);
+    append(&be32,sizeof be32);
+  }
+
+  void appendInt16(int16_t x) {
+    int16_t be16 = sockets::hostToNetwork16(x);
+    append(&be16,sizeof be16);
+  }
+
+  void appendInt8(int8_t x) {
+    append(&x,sizeof x);
+  }
+
+  //读出网络字节序的整数并取走，要求 readableBytes() >= sizeof(intN_t)
+  int64_t readInt64() {
+    int64_t result = peekInt64();
+    retrieve(sizeof result);
+    return result;
+  }
+
+  int32_t readInt32() {
+    int32_t result = peekInt32();
+    retrieve(sizeof result);
+    return result;
+  }
+
+  int16_t readInt16() {
+    int16_t result = peekInt16();
+    retrieve(sizeof result);
+    return result;
+  }
+
+  int8_t readInt8() {
+    int8_t result = peekInt8();
+    retrieve(sizeof result);
+    return result;
+  }
+
+  //只看不取
+  int64_t peekInt64() const {
+    assert(readableBytes() >= sizeof(int64_t));
+    int64_t be64 = 0;
+    ::memcpy(&be64,peek(),sizeof be64);
+    return sockets::networkToHost64(be64);
+  }
+
+  int32_t peekInt32() const {
+    assert(readableBytes() >= sizeof(int32_t));
+    int32_t be32 = 0;
+    ::memcpy(&be32,peek(),sizeof be32);
+    return sockets::networkToHost32(be32);
+  }
+
+  int16_t peekInt16() const {
+    assert(readableBytes() >= sizeof(int16_t));
+    int16_t be16 = 0;
+    ::memcpy(&be16,peek(),sizeof be16);
+    return sockets::networkToHost16(be16);
+  }
+
+  int8_t peekInt8() const {
+    assert(readableBytes() >= sizeof(int8_t));
+    int8_t x = *peek();
+    return x;
+  }
+
   void ensureWritableBytes(size_t len)  {
     if(writableBytes()<len) {
       makeSpace(len);
@@ -118,46 +284,140 @@ public:
 
   //在空闲取添加几个字节，创新点
   void prepend(const void* data,size_t len) {
+    if(buffer_ == nullptr) {
+      makeSpace(0);
+    }
     assert(len<=prependableBytes());
     readIndex -= len;
     const char* d = static_cast<const char*>(data);
     std::copy(d,d+len,begin()+readIndex);
   }
 
+  //在数据前面写入网络字节序的整数，适合在消息体写完之后补长度头：
+  //kCheapPrepend 个字节的预留空间足够放下 int64，消息体不用再搬动
+  void prependInt64(int64_t x) {
+    int64_t be64 = sockets::hostToNetwork64(x);
+    prepend(&be64,sizeof be64);
+  }
+
+  void prependInt32(int32_t x) {
+    int32_t be32 = sockets::hostToNetwork32(x);
+    prepend(&be32,sizeof be32);
+  }
+
+  void prependInt16(int16_t x) {
+    int16_t be16 = sockets::hostToNetwork16(x);
+    prepend(&be16,sizeof be16);
+  }
+
+  void prependInt8(int8_t x) {
+    prepend(&x,sizeof x);
+  }
+
+  //一次分配好能放下 n 字节数据(已有的可读数据加上之后写入的)的空间，
+  //已知消息大小时用它可以避免逐步扩容
+  void reserve(size_t n) {
+    if(buffer_ == nullptr || kCheapPrepend+n > capacity_) {
+      reallocate(std::max(n,readableBytes())-readableBytes());
+    }
+  }
+
+  //扩容时最多比原容量多分配多少字节，0 表示只分配刚好够用的空间
+  void setMaxGrowth(size_t n) { maxGrowth_ = n; }
+
   void shrink(size_t reserve)
   {
-    std::vector<char> buf(kCheapPrepend+readableBytes()+reserve);
-    std::copy(peek(), peek()+readableBytes(), buf.begin()+kCheapPrepend);
-    buf.swap(buffer_);
+    reallocate(readableBytes()+reserve);
   }
 
+  //没有可读数据时把内存还给池(不用池时直接释放)，下次写入时再分配。
+  //之前 peek() 等返回的指针随之失效，所以只在连接空闲或销毁时由调用方显式调用
+  void releaseStorage() {
+    if(readableBytes() != 0) {
+      return;
+    }
+    freeStorage();
+    buffer_ = nullptr;
+    capacity_ = 0;
+    readIndex = 0;
+    writeIndex = 0;
+  }
+
+  //当前占用的内存，已还给池时为 0
+  size_t capacity() const { return capacity_; }
+
+  //从 fd 读取数据。冷连接用栈上 64KB 的 extrabuf 兜底；
+  //最近读取量较大的连接按读取量(以及 FIONREAD 报告的待读字节数)预先扩容，数据只拷贝一次
   ssize_t readfd(int fd,int* savedErrno);
+  //最近读取量的估计，供测试和统计
+  size_t readHint() const { return readHint_; }
 
 private:
   char* begin() {
-    return &*buffer_.begin();
+    return buffer_;
   }
 
   const char* begin() const {
-    return &*buffer_.begin();
+    return buffer_;
+  }
+
+  //把可读数据搬到一块新内存的 kCheapPrepend 处，新内存至少还能写 writable 字节
+  void reallocate(size_t writable) {
+    const size_t readable = readableBytes();
+    size_t capacity = kCheapPrepend+readable+writable;
+    char* buf;
+    if(pool_ != nullptr) {
+      buf = pool_->allocate(capacity,&capacity);
+    }else {
+      buf = new char[capacity];
+    }
+    if(buffer_ != nullptr) {
+      ::memcpy(buf+kCheapPrepend,peek(),readable);
+    }
+    freeStorage();
+    buffer_ = buf;
+    capacity_ = capacity;
+    readIndex = kCheapPrepend;
+    writeIndex = kCheapPrepend+readable;
+  }
+
+  void freeStorage() {
+    if(pool_ != nullptr && buffer_ != nullptr) {
+      pool_->release(buffer_,capacity_);
+    }else {
+      delete[] buffer_;
+    }
+  }
+
+  void updateReadHint(size_t n) {
+    readHint_ = n >= readHint_ ? n : readHint_ - (readHint_ - n) / 8;
   }
 
   //自动增长
+  //可读数据不超过容量的一半时把它搬到前面，搬动的字节数不超过之后可以写入的字节数；
+  //否则按容量翻倍(最多多 maxGrowth_)扩容，流式追加时每个字节摊销下来只搬动常数次
   void makeSpace(size_t len) {
-    if(writableBytes()+prependableBytes()<len+kCheapPrepend) {
-      buffer_.resize(writeIndex+len);
-    }else { //重置两个index
+    const size_t readable = readableBytes();
+    if(buffer_ != nullptr && writableBytes()+prependableBytes()>=len+kCheapPrepend
+       && readable <= capacity_/2) { //重置两个index
       assert(kCheapPrepend<readIndex);
-      size_t readable = readableBytes();
-      std::copy(begin()+readIndex,begin()+writeIndex,begin()+kCheapPrepend);
+      ::memmove(begin()+kCheapPrepend,begin()+readIndex,readable);
       readIndex = kCheapPrepend;
       writeIndex = readIndex + readable;
       assert(readable == readableBytes());
+      return;
     }
+    const size_t needed = kCheapPrepend+readable+len;
+    const size_t grown = capacity_+std::min(capacity_,maxGrowth_);
+    reallocate(std::max(needed,grown)-kCheapPrepend-readable);
   }
-  std::vector<char> buffer_;
+  char* buffer_;     //已还给池时为 nullptr
+  size_t capacity_;
   size_t readIndex;
   size_t writeIndex;
+  size_t readHint_;  //最近读取量：增大时立即跟上，减小时按 1/8 衰减
+  size_t maxGrowth_;
+  BufferPool* pool_;
 };
 }
 
@@ -0,0 +1,86 @@
+#include "BufferPool.h"
+
+using namespace muduo;
+
+const size_t BufferPool::kMinBlockSize;
+const size_t BufferPool::kMaxBlockSize;
+
+BufferPool::BufferPool(size_t maxFreeBytesPerClass)
+  : maxFreeBytes_(maxFreeBytesPerClass),
+    freeBytes_(0),
+    inUse_(0)
+{
+  for(int i = 0; i < kNumClasses; ++i) {
+    free_[i] = nullptr;
+    classFreeBytes_[i] = 0;
+  }
+}
+
+BufferPool::~BufferPool() {
+  setMaxFreeBytes(0);
+}
+
+int BufferPool::classOf(size_t size) {
+  int cls = 0;
+  size_t blockSize = kMinBlockSize;
+  while(blockSize < size) {
+    blockSize <<= 1;
+    if(++cls >= kNumClasses) {
+      return -1;
+    }
+  }
+  return cls;
+}
+
+char* BufferPool::allocate(size_t size,size_t* capacity) {
+  int cls = classOf(size);
+  if(cls < 0) {
+    *capacity = size;
+    inUse_ += size;
+    return new char[size];
+  }
+  size_t blockSize = kMinBlockSize << cls;
+  *capacity = blockSize;
+  inUse_ += blockSize;
+  FreeBlock* block = free_[cls];
+  if(block != nullptr) {
+    free_[cls] = block->next;
+    classFreeBytes_[cls] -= blockSize;
+    freeBytes_ -= blockSize;
+    return reinterpret_cast<char*>(block);
+  }
+  return new char[blockSize];
+}
+
+void BufferPool::release(char* block,size_t capacity) {
+  inUse_ -= capacity < inUse_ ? capacity : inUse_;
+  int cls = classOf(capacity);
+  if(cls < 0 || (kMinBlockSize << cls) != capacity
+     || classFreeBytes_[cls] + capacity > maxFreeBytes_) {
+    delete[] block;
+    return;
+  }
+  FreeBlock* node = reinterpret_cast<FreeBlock*>(block);
+  node->next = free_[cls];
+  free_[cls] = node;
+  classFreeBytes_[cls] += capacity;
+  freeBytes_ += capacity;
+}
+
+void BufferPool::setMaxFreeBytes(size_t n) {
+  maxFreeBytes_ = n;
+  for(int i = 0; i < kNumClasses; ++i) {
+    trim(i);
+  }
+}
+
+void BufferPool::trim(int cls) {
+  const size_t blockSize = kMinBlockSize << cls;
+  while(classFreeBytes_[cls] > maxFreeBytes_) {
+    FreeBlock* block = free_[cls];
+    free_[cls] = block->next;
+    classFreeBytes_[cls] -= blockSize;
+    freeBytes_ -= blockSize;
+    delete[] reinterpret_cast<char*>(block);
+  }
+}
@@ -0,0 +1,54 @@
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+
+#include <cstddef>
+
+namespace muduo {
+
+///
+/// 每个 EventLoop 一个的 Buffer 内存池，按 2 的幂分档(1KB ~ 1MB)，每档一条空闲链表
+/// 只能在所属的循环线程中使用，因此不加锁
+/// 每档空闲内存超过 maxFreeBytes 时直接释放；超过最大档位的请求不进池
+///
+class BufferPool {
+public:
+  static const size_t kMinBlockSize = 1024;
+  static const int kNumClasses = 11;
+  static const size_t kMaxBlockSize = kMinBlockSize << (kNumClasses - 1);  //1MB
+  static const size_t kDefaultMaxFreeBytes = 4 * 1024 * 1024;  //每档
+
+  explicit BufferPool(size_t maxFreeBytesPerClass = kDefaultMaxFreeBytes);
+  ~BufferPool();
+
+  BufferPool(const BufferPool&) = delete;
+  BufferPool& operator=(const BufferPool&) = delete;
+
+  //分配至少 size 字节，*capacity 返回实际可用的大小
+  char* allocate(size_t size,size_t* capacity);
+  //capacity 必须是 allocate 返回的大小；不是档位大小的内存(例如 new char[] 得到的)直接释放
+  void release(char* block,size_t capacity);
+
+  void setMaxFreeBytes(size_t n);
+  size_t freeBytes() const { return freeBytes_; }
+  //已分配但还没有归还的字节数
+  size_t bytesInUse() const { return inUse_; }
+
+private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  //能容纳 size 的最小档位，超过最大档位时返回 -1
+  static int classOf(size_t size);
+  void trim(int cls);
+
+  FreeBlock* free_[kNumClasses];
+  size_t classFreeBytes_[kNumClasses];
+  size_t maxFreeBytes_;
+  size_t freeBytes_;
+  size_t inUse_;
+};
+
+}
+
+#endif //BUFFERPOOL_H
@@ -0,0 +1,298 @@
+#include "ByteSearch.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define MUDUO_BYTESEARCH_X86 1
+#include <immintrin.h>
+#endif
+
+namespace muduo
+{
+namespace ByteSearch
+{
+
+namespace
+{
+
+typedef const char* (*FindByteFunc)(const char*, const char*, char);
+typedef const char* (*FindCRLFFunc)(const char*, const char*);
+
+// glibc 的 memchr 本身已经向量化，标量实现直接用它
+const char* findByteScalar(const char* begin, const char* end, char c)
+{
+  return static_cast<const char*>(::memchr(begin, c, end - begin));
+}
+
+const char* findCRLFScalar(const char* begin, const char* end)
+{
+  while (end - begin >= 2)
+  {
+    const char* cr = findByteScalar(begin, end - 1, '\r');
+    if (cr == nullptr)
+    {
+      return nullptr;
+    }
+    if (cr[1] == '\n')
+    {
+      return cr;
+    }
+    begin = cr + 1;
+  }
+  return nullptr;
+}
+
+#ifdef MUDUO_BYTESEARCH_X86
+// findCRLF 用两次错开一个字节的不对齐加载，分别比较 '\r' 和它后面的 '\n'，结果对齐到同一个位
+// 所有向量循环都不越过 end，剩下不足一个向量的尾部交给标量实现
+
+__attribute__((target("sse2")))
+const char* findByteSse2(const char* begin, const char* end, char c)
+{
+  const __m128i needle = _mm_set1_epi8(c);
+  const char* p = begin;
+  for (; end - p >= 16; p += 16)
+  {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, needle));
+    if (mask != 0)
+    {
+      return p + __builtin_ctz(mask);
+    }
+  }
+  return findByteScalar(p, end, c);
+}
+
+__attribute__((target("sse2")))
+const char* findCRLFSse2(const char* begin, const char* end)
+{
+  const __m128i cr = _mm_set1_epi8('\r');
+  const __m128i lf = _mm_set1_epi8('\n');
+  const char* p = begin;
+  for (; end - p >= 17; p += 16)
+  {
+    __m128i c = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), cr);
+    if (_mm_movemask_epi8(c) == 0)
+    {
+      continue;
+    }
+    __m128i l = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1)), lf);
+    int mask = _mm_movemask_epi8(_mm_and_si128(c, l));
+    if (mask != 0)
+    {
+      return p + __builtin_ctz(mask);
+    }
+  }
+  return findCRLFScalar(p, end);
+}
+
+// AVX2：不足 kAvx2MinRange 字节时向量化的准备开销不划算，直接走标量(memchr)；
+// 否则先查一个不对齐的块，之后按 32 字节对齐，每轮 128 字节，
+// 四个向量的比较结果合并后只做一次判断，命中后再确定具体位置
+const ptrdiff_t kAvx2MinRange = 64;
+
+__attribute__((target("avx2")))
+inline unsigned byteMask(const char* p, __m256i needle)
+{
+  return static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), needle)));
+}
+
+// p 开始的 32 个位置上的 CRLF，要求 p+32 可读
+__attribute__((target("avx2")))
+inline unsigned crlfMask(const char* p, __m256i cr, __m256i lf)
+{
+  __m256i c = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), cr);
+  __m256i l = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 1)), lf);
+  return static_cast<unsigned>(_mm256_movemask_epi8(_mm256_and_si256(c, l)));
+}
+
+inline const char* alignUp32(const char* p)
+{
+  return reinterpret_cast<const char*>((reinterpret_cast<uintptr_t>(p) + 31) & ~uintptr_t(31));
+}
+
+__attribute__((target("avx2")))
+const char* findByteAvx2(const char* begin, const char* end, char c)
+{
+  if (end - begin < kAvx2MinRange)
+  {
+    return findByteScalar(begin, end, c);
+  }
+  const __m256i needle = _mm256_set1_epi8(c);
+  unsigned mask = byteMask(begin, needle);
+  if (mask != 0)
+  {
+    return begin + __builtin_ctz(mask);
+  }
+  const char* p = alignUp32(begin + 1);
+  for (; end - p >= 128; p += 128)
+  {
+    const __m256i* v = reinterpret_cast<const __m256i*>(p);
+    __m256i e0 = _mm256_cmpeq_epi8(_mm256_load_si256(v), needle);
+    __m256i e1 = _mm256_cmpeq_epi8(_mm256_load_si256(v + 1), needle);
+    __m256i e2 = _mm256_cmpeq_epi8(_mm256_load_si256(v + 2), needle);
+    __m256i e3 = _mm256_cmpeq_epi8(_mm256_load_si256(v + 3), needle);
+    __m256i any = _mm256_or_si256(_mm256_or_si256(e0, e1), _mm256_or_si256(e2, e3));
+    if (_mm256_testz_si256(any, any))
+    {
+      continue;
+    }
+    const __m256i hits[4] = { e0, e1, e2, e3 };
+    for (int i = 0; i < 4; ++i)
+    {
+      mask = static_cast<unsigned>(_mm256_movemask_epi8(hits[i]));
+      if (mask != 0)
+      {
+        return p + 32 * i + __builtin_ctz(mask);
+      }
+    }
+  }
+  for (; end - p >= 32; p += 32)
+  {
+    mask = byteMask(p, needle);
+    if (mask != 0)
+    {
+      return p + __builtin_ctz(mask);
+    }
+  }
+  return findByteScalar(p, end, c);
+}
+
+// 先只找 '\r'，有 '\r' 的轮次才检查后一个字节是否为 '\n'
+__attribute__((target("avx2")))
+const char* findCRLFAvx2(const char* begin, const char* end)
+{
+  if (end - begin < kAvx2MinRange)
+  {
+    return findCRLFScalar(begin, end);
+  }
+  const __m256i cr = _mm256_set1_epi8('\r');
+  const __m256i lf = _mm256_set1_epi8('\n');
+  unsigned mask = crlfMask(begin, cr, lf);
+  if (mask != 0)
+  {
+    return begin + __builtin_ctz(mask);
+  }
+  const char* p = alignUp32(begin + 1);
+  for (; end - p >= 129; p += 128)
+  {
+    const __m256i* v = reinterpret_cast<const __m256i*>(p);
+    __m256i c0 = _mm256_cmpeq_epi8(_mm256_load_si256(v), cr);
+    __m256i c1 = _mm256_cmpeq_epi8(_mm256_load_si256(v + 1), cr);
+    __m256i c2 = _mm256_cmpeq_epi8(_mm256_load_si256(v + 2), cr);
+    __m256i c3 = _mm256_cmpeq_epi8(_mm256_load_si256(v + 3), cr);
+    __m256i any = _mm256_or_si256(_mm256_or_si256(c0, c1), _mm256_or_si256(c2, c3));
+    if (_mm256_testz_si256(any, any))
+    {
+      continue;
+    }
+    for (int i = 0; i < 4; ++i)
+    {
+      mask = crlfMask(p + 32 * i, cr, lf);
+      if (mask != 0)
+      {
+        return p + 32 * i + __builtin_ctz(mask);
+      }
+    }
+  }
+  for (; end - p >= 33; p += 32)
+  {
+    mask = crlfMask(p, cr, lf);
+    if (mask != 0)
+    {
+      return p + __builtin_ctz(mask);
+    }
+  }
+  return findCRLFScalar(p, end);
+}
+#endif
+
+bool supported(Impl impl)
+{
+  switch (impl)
+  {
+    case kScalar:
+      return true;
+#ifdef MUDUO_BYTESEARCH_X86
+    case kSse2:
+      return __builtin_cpu_supports("sse2");
+    case kAvx2:
+      return __builtin_cpu_supports("avx2");
+#endif
+    default:
+      return false;
+  }
+}
+
+std::atomic<FindByteFunc> g_findByte(&findByteScalar);
+std::atomic<FindCRLFFunc> g_findCRLF(&findCRLFScalar);
+std::atomic<int> g_impl(kScalar);
+
+void install(Impl impl)
+{
+  switch (impl)
+  {
+#ifdef MUDUO_BYTESEARCH_X86
+    case kAvx2:
+      g_findByte.store(&findByteAvx2, std::memory_order_relaxed);
+      g_findCRLF.store(&findCRLFAvx2, std::memory_order_relaxed);
+      break;
+    case kSse2:
+      g_findByte.store(&findByteSse2, std::memory_order_relaxed);
+      g_findCRLF.store(&findCRLFSse2, std::memory_order_relaxed);
+      break;
+#endif
+    default:
+      g_findByte.store(&findByteScalar, std::memory_order_relaxed);
+      g_findCRLF.store(&findCRLFScalar, std::memory_order_relaxed);
+      break;
+  }
+  g_impl.store(impl, std::memory_order_relaxed);
+}
+
+}
+
+const char* findByte(const char* begin, const char* end, char c)
+{
+  return g_findByte.load(std::memory_order_relaxed)(begin, end, c);
+}
+
+const char* findCRLF(const char* begin, const char* end)
+{
+  return g_findCRLF.load(std::memory_order_relaxed)(begin, end);
+}
+
+Impl currentImpl()
+{
+  return static_cast<Impl>(g_impl.load(std::memory_order_relaxed));
+}
+
+bool setImpl(Impl impl)
+{
+  if (!supported(impl))
+  {
+    return false;
+  }
+  install(impl);
+  return true;
+}
+
+const char* implName(Impl impl)
+{
+  switch (impl)
+  {
+    case kAvx2:
+      return "avx2";
+    case kSse2:
+      return "sse2";
+    default:
+      return "scalar";
+  }
+}
+
+}
+}
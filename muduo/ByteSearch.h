@@ -0,0 +1,33 @@
+#ifndef BYTESEARCH_H
+#define BYTESEARCH_H
+
+namespace muduo {
+
+///
+/// Buffer 的分隔符查找，找不到时都返回 nullptr
+///
+/// 默认使用基于 memchr 的标量实现：glibc 的 memchr 已经按 CPU 选用手工调过的向量实现，
+/// test15 中比这里的向量实现更快。
+/// x86 上另有 SSE2 和 AVX2 两套向量实现，只在显式调用 setImpl() 后使用，
+/// 供 memchr 没有向量化的 C 库选用，test15 校验它们与标量实现的结果一致
+///
+namespace ByteSearch {
+
+enum Impl { kScalar, kSse2, kAvx2 };
+
+// 在 [begin, end) 中查找第一个 c
+const char* findByte(const char* begin,const char* end,char c);
+// 在 [begin, end) 中查找第一个 "\r\n"，返回 '\r' 的位置
+const char* findCRLF(const char* begin,const char* end);
+
+// 当前使用的实现，默认为 kScalar
+Impl currentImpl();
+// 切换实现，CPU 不支持时返回 false。应在启动时、没有其他线程查找时调用
+bool setImpl(Impl impl);
+const char* implName(Impl impl);
+
+}
+
+}
+
+#endif //BYTESEARCH_H
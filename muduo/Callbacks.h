@@ -21,6 +21,9 @@ typedef std::function<void (const TcpConnectionPtr&,
 typedef std::function<void(const TcpConnectionPtr&)> CloseCallback;
 
 typedef std::function<void(const TcpConnectionPtr&)> WriteCompleteCallback;
+//待发送字节数越过高/低水位时调用，第二个参数是当时的待发送字节数
+typedef std::function<void(const TcpConnectionPtr&, size_t)> HighWaterMarkCallback;
+typedef std::function<void(const TcpConnectionPtr&, size_t)> LowWaterMarkCallback;
 
 
 }
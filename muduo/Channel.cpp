@@ -14,11 +14,12 @@
 using namespace muduo;
 
 const int muduo::Channel::kNoneEvent = 0;
-const int muduo::Channel::kReadEvent = POLLIN/POLLPRI;
+const int muduo::Channel::kReadEvent = POLLIN|POLLPRI;
 const int muduo::Channel::kWriteEvent = POLLOUT;
 
 muduo::Channel::Channel(muduo::EventLoop* loop,int fdArg)
-  :loop_(loop),fd_(fdArg),events_(0),revents_(0),index_(-1),eventHandling_(false)
+  :loop_(loop),fd_(fdArg),events_(0),revents_(0),index_(-1),eventHandling_(false),
+   edgeTriggered_(false)
 {
 }
 
@@ -46,8 +47,8 @@ void muduo::Channel::handleEvent(Timestamp receiveTime) {
     if(closeCallback_) closeCallback_();
   }
 
-  if(revents_&(POLLIN|POLLPRI/POLLRDHUP)) {
-    if(readCallback_){return readCallback_(receiveTime);}
+  if(revents_&(POLLIN|POLLPRI|POLLRDHUP)) {
+    if(readCallback_) readCallback_(receiveTime);
   }
   if(revents_&(POLLOUT)) {
     if(writeCallback_) writeCallback_();
@@ -38,8 +38,15 @@ public:
   void enableReading(){events_|=kReadEvent;update();}
   void enableWriting(){events_|=kWriteEvent;update();}
   void disableWriting(){events_&= ~kWriteEvent;update();}
+  void disableReading(){events_&= ~kReadEvent;update();}
   void disableAll(){events_= kNoneEvent;update();}
   bool isWriting() const {return events_ & kWriteEvent;}
+  bool isReading() const {return events_ & kReadEvent;}
+
+  //边缘触发(EPOLLET)，仅对EPoller生效，PollPoller始终是水平触发
+  //已注册到Poller的Channel修改该选项必须在循环线程中进行
+  void setEdgeTriggered(bool on){edgeTriggered_ = on;if(!isNoneEvent()) update();}
+  bool isEdgeTriggered() const {return edgeTriggered_;}
 
 
 
@@ -64,6 +71,7 @@ private:
   int index_;
 
   bool eventHandling_;
+  bool edgeTriggered_;
 
   EventCallback writeCallback_;
   EventCallback errorCallback_;
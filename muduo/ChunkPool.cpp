@@ -0,0 +1,51 @@
+#include "ChunkPool.h"
+
+using namespace muduo;
+
+ChunkPool::ChunkPool(size_t maxFreeChunks)
+  : free_(nullptr),
+    numFree_(0),
+    maxFree_(maxFreeChunks),
+    inUse_(0)
+{
+}
+
+ChunkPool::~ChunkPool() {
+  setMaxFreeChunks(0);
+}
+
+Chunk* ChunkPool::allocate() {
+  Chunk* chunk = free_;
+  if(chunk != nullptr) {
+    free_ = chunk->next;
+    --numFree_;
+  }else {
+    chunk = new Chunk;
+  }
+  chunk->next = nullptr;
+  chunk->readIndex = 0;
+  chunk->writeIndex = 0;
+  ++inUse_;
+  return chunk;
+}
+
+void ChunkPool::release(Chunk* chunk) {
+  --inUse_;
+  if(numFree_ >= maxFree_) {
+    delete chunk;
+    return;
+  }
+  chunk->next = free_;
+  free_ = chunk;
+  ++numFree_;
+}
+
+void ChunkPool::setMaxFreeChunks(size_t n) {
+  maxFree_ = n;
+  while(numFree_ > maxFree_) {
+    Chunk* chunk = free_;
+    free_ = chunk->next;
+    --numFree_;
+    delete chunk;
+  }
+}
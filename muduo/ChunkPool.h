@@ -0,0 +1,53 @@
+#ifndef CHUNKPOOL_H
+#define CHUNKPOOL_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace muduo {
+
+//输出队列使用的定长内存块，通过 next 串成单链表
+struct Chunk {
+  static const size_t kSize = 16 * 1024 - 32;  //连同头部约 16KB
+
+  Chunk* next;
+  size_t readIndex;
+  size_t writeIndex;
+  char data[kSize];
+
+  size_t readableBytes() const { return writeIndex - readIndex; }
+  size_t writableBytes() const { return kSize - writeIndex; }
+};
+
+///
+/// 每个 EventLoop 一个的 Chunk 空闲链表，只能在所属的循环线程中使用，因此不加锁
+/// 空闲块超过 maxFreeChunks 时直接释放，避免一次突发之后长期占着内存
+///
+class ChunkPool {
+public:
+  static const size_t kDefaultMaxFreeChunks = 256;  //4MB
+
+  explicit ChunkPool(size_t maxFreeChunks = kDefaultMaxFreeChunks);
+  ~ChunkPool();
+
+  ChunkPool(const ChunkPool&) = delete;
+  ChunkPool& operator=(const ChunkPool&) = delete;
+
+  Chunk* allocate();
+  void release(Chunk* chunk);
+
+  void setMaxFreeChunks(size_t n);
+  size_t freeChunks() const { return numFree_; }
+  //在用的块数(已分配但还没有归还的)
+  size_t chunksInUse() const { return inUse_; }
+
+private:
+  Chunk* free_;
+  size_t numFree_;
+  size_t maxFree_;
+  size_t inUse_;
+};
+
+}
+
+#endif //CHUNKPOOL_H
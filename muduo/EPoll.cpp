@@ -3,13 +3,15 @@
 #include <poll.h>
 #include <sys/epoll.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
+#include <cstring>
 #include <ostream>
+#include <unistd.h>
 
 #include "../muduo/log//base/Logging.h"
 #include "Channel.h"
-#include <bits/poll.h>
 using namespace muduo;
 
 static_assert(EPOLLIN == POLLIN, "EPOLLIN and POLLIN constants must match");
@@ -20,18 +22,24 @@ static_assert(EPOLLERR == POLLERR, "EPOLLERR and POLLERR constants must match");
 static_assert(EPOLLHUP == POLLHUP, "EPOLLHUP and POLLHUP constants must match");
 
 
+const int EPoller::kInitEventListSize;
+const int EPoller::kDefaultMaxEventListSize;
+
 const int kNew = -1;
 const int kAdded = 1;
-const int kDeleted  = 2;
 
 //构造函数，创建epoll实例，并分配初始事件列表大小
  EPoller::EPoller(EventLoop* loop)
-   :ownerLoop_(loop),
-    epollfd_(::epoll_create(EPOLL_CLOEXEC)),
-    events_(kInitEventListSize)
+   :Poller(loop),
+    epollfd_(::epoll_create1(EPOLL_CLOEXEC)),
+    events_(kInitEventListSize),
+    maxEventListSize_(kDefaultMaxEventListSize),
+    lowUsageWakeups_(0)
 {
+   stats_.eventListSize = events_.size();
    if(epollfd_ < 0) {
      LOG << "EPoller::EPoller()";
+     abort();
    }
 }
 
@@ -45,18 +53,24 @@ const int kDeleted  = 2;
 
 Timestamp EPoller::poll(int timeoutMs,ChannelList* activeChannels)
 {
-   int numEvents = ::epoll_wait(epollfd_,&*events_.begin(),static_cast<int>(events_.size()),timeoutMs);
+   applyPendingChanges();
+   int numEvents = ::epoll_wait(epollfd_,events_.data(),static_cast<int>(events_.size()),timeoutMs);
+   int savedErrno = errno;
    Timestamp now = Timestamp::now();
-   if(numEvents < 0) {
+   if(numEvents >= 0) {
+     recordWakeup(numEvents);
+   }
+   if(numEvents > 0) {
      LOG<<numEvents<<"events happened";
      fillActiveChannels(numEvents,activeChannels);
-     if(static_cast<size_t>(numEvents) == events_.size()) {
-       events_.resize(events_.size() * 2);
-     }
+     adjustEventList(numEvents);
    }else if(numEvents == 0) {
-     LOG<<" nothing happened";
-   }else {
-     LOG<<"EPoller::poll()";
+     adjustEventList(0);
+     if(timeoutMs != 0) {  //忙轮询时不记录
+       LOG<<" nothing happened";
+     }
+   }else if(savedErrno != EINTR) {
+     LOG<<"EPoller::poll() errno="<<savedErrno;
    }
    return now;
 }
@@ -64,35 +78,79 @@ Timestamp EPoller::poll(int timeoutMs,ChannelList* activeChannels)
 //将活跃事件填充到activeChannels列表中
 void EPoller::fillActiveChannels(int numEvents,ChannelList* activeChannels) const
 {
-   assert(static_cast<size_t>(numEvents)<events_.size());
+   assert(static_cast<size_t>(numEvents)<=events_.size());
    for(int i=0;i<numEvents;++i) {
      Channel* channel = static_cast<Channel*>(events_[i].data.ptr);
+     assert(hasChannel(channel));
      channel -> set_revents(events_[i].events); //设置事件
      activeChannels->push_back(channel);
    }
  }
 
-//更新epoll中的Channel，根据需要添加，修改或删除十斤啊
+//数组被填满时加倍(不超过上限)；长期使用不足1/4时减半并释放内存，
+//两个阈值之间留有余量，避免在边界上来回抖动
+void EPoller::adjustEventList(int numEvents)
+{
+   const size_t size = events_.size();
+   if(static_cast<size_t>(numEvents) == size && size < maxEventListSize_) {
+     events_.resize(std::min(size * 2,maxEventListSize_));
+     ++stats_.eventListGrows;
+     lowUsageWakeups_ = 0;
+   }else if(size > kInitEventListSize && static_cast<size_t>(numEvents) <= size / 4) {
+     if(++lowUsageWakeups_ >= kShrinkAfterWakeups) {
+       EventList(std::max(size / 2,static_cast<size_t>(kInitEventListSize))).swap(events_);
+       ++stats_.eventListShrinks;
+       lowUsageWakeups_ = 0;
+     }
+   }else {
+     lowUsageWakeups_ = 0;
+   }
+   stats_.eventListSize = events_.size();
+}
+
+void EPoller::setMaxEventsPerPoll(int maxEvents)
+{
+   assertInLoopThread();
+   maxEventListSize_ = std::max(maxEvents,kInitEventListSize);
+   if(events_.size() > maxEventListSize_) {
+     EventList(maxEventListSize_).swap(events_);
+     stats_.eventListSize = events_.size();
+   }
+}
+
+EPoller::FdState& EPoller::fdState(int fd)
+{
+   assert(fd >= 0);
+   if(static_cast<size_t>(fd) >= fdStates_.size()) {
+     fdStates_.resize(fd + 1);
+   }
+   return fdStates_[fd];
+}
+
+//记录Channel期望的事件，真正的epoll_ctl推迟到下一次poll之前
 
 void EPoller::updateChannel(Channel* channel)
 {
    assertInLoopThread();
-   const int index = channel->index();
-   if(index == kNew || index == kDeleted) {
-     int fd = channel->fd();
-     if(index  == kNew) {
-       channels_[fd] = channel;
-     }
+   const int fd = channel->fd();
+   if(channel->index() == kNew) {
+     assert(channels_.find(fd) == channels_.end());
+     channels_[fd] = channel;
      channel->set_index(kAdded);
-     update(EPOLL_CTL_ADD,channel);
    }else {
-     int fd  = channel->fd();
-     if(channel->isNoneEvent()) {
-       update(EPOLL_CTL_DEL, channel);
-       channel->set_index(kDeleted);
-     }else {
-       update(EPOLL_CTL_MOD,channel);
-     }
+     assert(hasChannel(channel));
+   }
+
+   FdState& state = fdState(fd);
+   state.wanted = channel->events();
+   if(state.wanted != 0 && channel->isEdgeTriggered()) {
+     state.wanted |= EPOLLET;
+   }
+   if(state.pending) {
+     ++stats_.ctlElided;  //与本轮之前的修改合并
+   }else {
+     state.pending = true;
+     pendingFds_.push_back(fd);
    }
 }
 
@@ -100,35 +158,56 @@ void EPoller::updateChannel(Channel* channel)
 void EPoller::removeChannel(Channel* channel){
    assertInLoopThread();
    int fd = channel->fd();
-   channels_.erase(fd);
-
-   if(channel->index() == kAdded) {
-     update(EPOLL_CTL_DEL,channel);
+   assert(hasChannel(channel));
+   assert(channel->isNoneEvent());
+   size_t n = channels_.erase(fd);
+   assert(n == 1); (void)n;
+
+   //文件描述符随后会被关闭并可能被复用，注销不能推迟
+   FdState& state = fdState(fd);
+   if(state.registered != 0) {
+     update(EPOLL_CTL_DEL,fd,0,channel);
    }
+   state.wanted = 0;
+   state.registered = 0;
    channel->set_index(kNew);
 }
 
+//提交所有待处理的修改，每个文件描述符至多一次epoll_ctl
+void EPoller::applyPendingChanges()
+{
+   for(int fd : pendingFds_) {
+     FdState& state = fdStates_[fd];
+     state.pending = false;
+     if(state.wanted == state.registered) {
+       ++stats_.ctlElided;
+       continue;
+     }
+     Channel* channel = nullptr;
+     if(state.wanted != 0) {
+       auto it = channels_.find(fd);
+       assert(it != channels_.end());
+       channel = it->second;
+     }
+     int operation = state.registered == 0 ? EPOLL_CTL_ADD
+                   : state.wanted == 0 ? EPOLL_CTL_DEL : EPOLL_CTL_MOD;
+     update(operation,fd,state.wanted,channel);
+     state.registered = state.wanted;
+   }
+   pendingFds_.clear();
+}
+
 //执行epoll的事件更新操作(添加，修改或删除)
-void EPoller::update(int operation,Channel* channel) {
+void EPoller::update(int operation,int fd,int events,Channel* channel) {
    struct epoll_event event;
-   bzero(&event,sizeof event);
-   event.events = channel->events();
+   memset(&event,0,sizeof event);
+   event.events = events;
    event.data.ptr = channel;
-   int fd  = channel->fd();
+   ++stats_.ctlIssued;
    if(::epoll_ctl(epollfd_,operation,fd,&event)<0) {
-     if(operation == EPOLL_CTL_DEL) {
-       if(operation == EPOLL_CTL_DEL) {
-         LOG<<"epoll_ctl op=" << operation << " fd=" << fd;
-       }else {
-         LOG<<"epoll_ctl op=" << operation << " fd=" << fd;
-       }
+     LOG<<"epoll_ctl op=" << operation << " fd=" << fd << " errno=" << errno;
+     if(operation != EPOLL_CTL_DEL) {
+       abort();
      }
    }
  }
-
-
-
-
-
-
-
@@ -3,11 +3,10 @@
 #ifndef EPOLL_H
 #define EPOLL_H
 
-#include <map>
 #include <vector>
 
+#include "Poller.h"
 #include "TimeStamp.h"
-#include "EventLoop.h"
 
 struct epoll_event;
 
@@ -17,46 +16,65 @@ class Channel;
 
 //使用epoll 实现的IO多路复用
 //该类不拥有Channel对象的所有权
+//updateChannel 只记录期望的事件掩码，在下一次 epoll_wait 之前统一提交，
+//同一轮循环内的多次修改只产生一次 epoll_ctl，掩码未变则不调用
 
-class EPoller {
+class EPoller : public Poller {
 public:
-  typedef std::vector<Channel*> ChannelList;
-
   //构造函数，初始化事件循环和epoll文件描述符
-  EPoller(EventLoop* loop);
+  explicit EPoller(EventLoop* loop);
 
   //析构函数
-  ~EPoller();
+  ~EPoller() override;
 
   //轮询I/O事件，必须在循环线程中调用
-  Timestamp poll(int timeoutMs,ChannelList* activeChannels);
+  Timestamp poll(int timeoutMs,ChannelList* activeChannels) override;
 
   //更新感兴趣的I/O事件，必须在循环线程中调用
-  void updateChannel(Channel* channel);
+  void updateChannel(Channel* channel) override;
 
   //移除某个Channel_,通常在Channel_析构时调用，必须在循环线程中调用
-  void removeChannel(Channel* channel);
+  void removeChannel(Channel* channel) override;
 
-  //确保操作在循环线程中进行
-  void assertInLoopThread();
+  //事件数组的上限，至少为 kInitEventListSize
+  void setMaxEventsPerPoll(int maxEvents) override;
 
 private:
   static const int kInitEventListSize = 16;
+  static const int kDefaultMaxEventListSize = 4096;
+  //连续这么多次唤醒都只用到不足1/4时，事件数组减半
+  static const int kShrinkAfterWakeups = 128;
+
+  //根据本次返回的事件数扩大或缩小事件数组
+  void adjustEventList(int numEvents);
 
   //填充活跃的Channel的列表
   void fillActiveChannels(int numEvents,ChannelList* activeChannels) const;
 
+  //提交本轮循环积累的事件修改
+  void applyPendingChanges();
+
   //更新epoll中的事件
-  void update(int operation,Channel* channel_);
+  void update(int operation,int fd,int events,Channel* channel);
+
+  //每个文件描述符的注册状态
+  struct FdState {
+    int wanted = 0;       //Channel 期望的事件掩码(含EPOLLET)
+    int registered = 0;   //已提交给内核的事件掩码，0 表示未注册
+    bool pending = false; //是否在 pendingFds_ 中
+  };
+
+  FdState& fdState(int fd);
 
-  //使用vector存储epoll_event和map存储文件描述符到Channel的映射
+  //使用vector存储epoll_event，文件描述符到Channel的映射在基类 channels_ 中
   typedef std::vector<struct epoll_event> EventList;
-  typedef std::map<int,Channel*> ChannelMap;
 
-  EventLoop* ownerLoop_; //拥有该EPoller的事件循环
   int epollfd_;  //epoll文件描述符
-  EventList events_; //存储时间的列表
-  ChannelMap channels_;  //存储每个文件描述符对应的Channel
+  EventList events_; //存储事件的列表
+  size_t maxEventListSize_;  //事件数组上限
+  int lowUsageWakeups_;      //连续低使用率的唤醒次数
+  std::vector<FdState> fdStates_;  //以文件描述符为下标
+  std::vector<int> pendingFds_;    //本轮有修改待提交的文件描述符
 
 };
 
@@ -6,12 +6,14 @@
 #include <unistd.h>
 
 #include <cassert>
+#include <chrono>
 
 #include "../muduo/log//base/Logging.h"
 #include "Callbacks.h"
 #include "Channel.h"
 #include "TimerId.h"
 #include "TimerQueue.h"
+#include "thread/CpuAffinity.h"
 
 #include <sys/eventfd.h>
 
@@ -33,15 +35,26 @@ static int createEventfd()
 }
 
 
-EventLoop::EventLoop():looping_(false),threadId_(CurrentThread::tid()),
+EventLoop::EventLoop():EventLoop(Poller::kDefaultBackend)
+{
+}
+
+EventLoop::EventLoop(Poller::Backend backend):looping_(false),threadId_(CurrentThread::tid()),
 quit_(false),callingPendingFunctors(false),
-poller_(new Poller(this)),
+busyPollUs_(0),
+numaNode_(CpuAffinity::currentNumaNode()),
+numConnections_(0),
+queuedBytes_(0),
+poller_(Poller::newPoller(this,backend)),
 timerQueue_(new TimerQueue(this)),
 wakeupFd_(createEventfd()),
-wakeupChannel_(new Channel(this,wakeupFd_))
+wakeupChannel_(new Channel(this,wakeupFd_)),
+wakeupPending_(false),
+wakeupWrites_(0),
+wakeupReads_(0)
 {
 
-  LOG<<"Eventloop created"<<this<<"in thread"<<threadId_;
+  LOG<<"Eventloop created"<<this<<"in thread"<<threadId_<<" numa node "<<numaNode_;
   if(t_loopInThisThread) {
     LOG<<"Another EventLoop"<<t_loopInThisThread
     <<"exists in this thread"<<threadId_;
@@ -58,26 +71,28 @@ EventLoop::~EventLoop() {
   t_loopInThisThread = nullptr;
 }
 
-void EventLoop::runInLoop(const Functor& cb) {
+void EventLoop::runInLoop(Functor cb) {
   if(isInLoopThread()) {
     cb();
   }else {
-    queueInLoop(cb);
+    queueInLoop(std::move(cb));
   }
 }
 
-void EventLoop::queueInLoop(const Functor& cb) {
-  {
-    MutexLockGuard lock(mutex_);
-    pendingFunctors_.push_back(cb);
-  }
+void EventLoop::queueInLoop(Functor cb) {
+  pendingFunctors_.push(std::move(cb));
   if(!isInLoopThread()||callingPendingFunctors) {
     wakeup();
   }
 }
 
 void EventLoop::wakeup() {
-  int one = 1;
+  //已有未处理的唤醒时不必再写，循环在执行 pendingFunctors_ 前会清除该标志
+  if(wakeupPending_.exchange(true,std::memory_order_acq_rel)) {
+    return;
+  }
+  wakeupWrites_.fetch_add(1,std::memory_order_relaxed);
+  uint64_t one = 1;
   ssize_t n = ::write(wakeupFd_,&one,sizeof one);
   if(n!=sizeof one) {
     LOG<<"EventLoop::wakeup() writes"<<n<<" bytes instead of 8";
@@ -91,9 +106,21 @@ void EventLoop::loop() {
   looping_ = true;
   quit_ = false;
 
+  typedef std::chrono::steady_clock Clock;
+  Clock::time_point lastActive = Clock::now();
+  bool spinning = false;
   while(!quit_) {
     activeChannels_.clear();
-    pollReturnTime_ = poller_->poll(kPollTimeMs,&activeChannels_);
+    pollReturnTime_ = poller_->poll(spinning ? 0 : kPollTimeMs,&activeChannels_);
+    if(busyPollUs_ > 0) {
+      Clock::time_point now = Clock::now();
+      if(!activeChannels_.empty()) {
+        lastActive = now;
+      }
+      spinning = now - lastActive < std::chrono::microseconds(busyPollUs_);
+    }else {
+      spinning = false;
+    }
     for(Poller::ChannelList::iterator it = activeChannels_.begin();it!=activeChannels_.end();++it) {
       (*it) -> handleEvent(pollReturnTime_);
     }
@@ -152,23 +179,25 @@ void EventLoop::cancel(TimerId timerId)
 
 
 void EventLoop::dePendingFunctors() {
-  std::vector<Functor> functors;
+  //必须先清除标志再取队列：之后入队的线程会重新写 eventfd，
+  //之前入队的元素则一定能被下面的 consume 看到
+  wakeupPending_.exchange(false,std::memory_order_acq_rel);
   callingPendingFunctors = true;
-
-  {
-    MutexLockGuard lock(mutex_);
-    functors.swap(pendingFunctors_);
-  }
-  for(size_t i = 0;i<functors.size();i++) {
-    functors[i]();
-  }
+  //只执行进入本函数时已经入队的functor，执行期间新入队的留到下一轮
+  size_t n = pendingFunctors_.consume([](Functor& functor) { functor(); },
+                                      kMaxPendingFunctorsPerLoop);
   callingPendingFunctors = false;
+  //这一批的唤醒已经被读掉了，还有剩余时要保证下一轮poll不会阻塞
+  if(n == kMaxPendingFunctorsPerLoop && !pendingFunctors_.empty()) {
+    wakeup();
+  }
 }
 
 void EventLoop::handleRead()
 {
   uint64_t one = 1;
   ssize_t n = ::read(wakeupFd_, &one, sizeof one);
+  ++wakeupReads_;
   if (n != sizeof one)
   {
     LOG<< "EventLoop::handleRead() reads " << n << " bytes instead of 8";
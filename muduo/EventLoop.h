@@ -4,18 +4,24 @@
 #define EVENTLOOP_H
 #include <sched.h>
 
+#include <atomic>
 #include <memory>
 
 #include "log//base/CurrentThread.h"
 
-#include "Poll.h"
+#include "BufferPool.h"
+#include "ChunkPool.h"
+#include "Poller.h"
+#include "Task.h"
 #include "TimerQueue.h"
+#include "thread/MpscQueue.h"
 
 namespace muduo {
-class Poller;
 class EventLoop {
 public:
   EventLoop();
+  //指定IO多路复用后端，kDefaultBackend 等价于默认构造
+  explicit EventLoop(Poller::Backend backend);
   ~EventLoop();
   void loop();
   void updateChannel(Channel* channel);
@@ -26,15 +32,17 @@ public:
     }
   }
 
-  typedef std::function<void()> Functor;
+  //只能移动，小闭包不分配内存，见 Task.h
+  typedef Task Functor;
 
   bool isInLoopThread() const{return threadId_ == CurrentThread::tid();}
   void quit();
   void wakeup();
 
-  void runInLoop(const Functor&cb) ;
+  //按值接收，调用者可以把闭包(及其捕获的数据)移动进来
+  void runInLoop(Functor cb);
 
-  void queueInLoop(const Functor& cb);
+  void queueInLoop(Functor cb);
 
   TimerId runAt(const Timestamp& time, const TimerCallback& cb);
   ///
@@ -48,6 +56,36 @@ public:
 
   void cancel(TimerId timerId);
 
+  //Poller 统计(epoll_ctl 发出/省略次数，每次唤醒的事件数等)，只应在循环线程中读取
+  const Poller::Stats& pollerStats() const { return poller_->stats(); }
+
+  //eventfd 唤醒的系统调用次数，多次唤醒会被合并为一次写和一次读
+  uint64_t wakeupWrites() const { return wakeupWrites_.load(std::memory_order_relaxed); }
+  uint64_t wakeupReads() const { return wakeupReads_; }
+
+  //忙轮询：最近一次有事件之后的 us 微秒内用0超时 poll 而不阻塞，
+  //以占用一个CPU核为代价降低唤醒延迟；0 表示关闭。必须在循环线程中调用
+  void setBusyPollUs(int us) { busyPollUs_ = us; }
+  int busyPollUs() const { return busyPollUs_; }
+
+  //该循环上的连接数以及它们输出缓冲区中尚未发出的字节数，
+  //由 TcpConnection 维护，供 EventLoopThreadPool 选择负载最轻的循环，可在任意线程读取
+  int numConnections() const { return numConnections_.load(std::memory_order_relaxed); }
+  int64_t queuedBytes() const { return queuedBytes_.load(std::memory_order_relaxed); }
+  void addConnections(int delta) { numConnections_.fetch_add(delta,std::memory_order_relaxed); }
+  void addQueuedBytes(int64_t delta) { queuedBytes_.fetch_add(delta,std::memory_order_relaxed); }
+
+  //本循环的 Chunk 空闲链表，供 TcpConnection 的输出队列使用，只能在循环线程中调用
+  ChunkPool* chunkPool() { return &chunkPool_; }
+  //本循环的 Buffer 内存池，供 TcpConnection 的输入缓冲区使用，只能在循环线程中调用
+  BufferPool* bufferPool() { return &bufferPool_; }
+
+  //创建循环时所在的NUMA节点，循环线程绑核后可据此在本节点上分配内存；未知时为 -1
+  int numaNode() const { return numaNode_; }
+
+  //单次 poll 最多处理的就绪事件数(epoll事件数组上限)，必须在循环线程中调用
+  void setMaxEventsPerPoll(int maxEvents) { poller_->setMaxEventsPerPoll(maxEvents); }
+
 
 private:
   void abortNotInLoopThread();
@@ -56,6 +94,9 @@ private:
 
   typedef std::vector<Channel*> ChannelList;
 
+  //每轮循环最多执行的 pending functor 个数，剩余的留到下一轮，避免饿死IO事件
+  static const size_t kMaxPendingFunctorsPerLoop = 1024;
+
 
 
   bool looping_;  //atomic
@@ -63,10 +104,20 @@ private:
   bool callingPendingFunctors; //atomic
   const pid_t threadId_;
   Timestamp pollReturnTime_;
+  int busyPollUs_;
+  const int numaNode_;
+  std::atomic<int> numConnections_;
+  std::atomic<int64_t> queuedBytes_;
+  ChunkPool chunkPool_;
+  BufferPool bufferPool_;
 
 
   int wakeupFd_;
   std::shared_ptr<Channel> wakeupChannel_;
+  //已经写过 eventfd 但循环还没有开始处理 pendingFunctors_ 时为 true
+  std::atomic<bool> wakeupPending_;
+  std::atomic<uint64_t> wakeupWrites_;
+  uint64_t wakeupReads_;
 
   std::shared_ptr<Poller> poller_;
 
@@ -74,8 +125,7 @@ private:
 
   std::shared_ptr<TimerQueue> timerQueue_;
 
-  std::vector<Functor> pendingFunctors_;
-  MutexLock mutex_;
+  MpscQueue<Functor> pendingFunctors_;  //无锁队列，任意线程入队，只有循环线程出队
 
 };
 
@@ -1,15 +1,19 @@
 
 #include "EventLoop.h"
 #include "EventLoopThread.h"
+#include "log/base/Logging.h"
+
+#include <cerrno>
 
 using namespace muduo;
 
-EventLoopThread::EventLoopThread()
+EventLoopThread::EventLoopThread(const ThreadInitCallback& cb)
   :loop_(nullptr),
    exiting_(false),
    thread_(std::bind(&EventLoopThread::threadFunc,this)),
    mutex_(),
-   cond_(mutex_)
+   cond_(mutex_),
+   callback_(cb)
 {
 
 }
@@ -33,7 +37,14 @@ EventLoop* EventLoopThread::startLoop() {
 }
 
 void EventLoopThread::threadFunc() {
+  //先绑核再创建 EventLoop，使循环的内存按首次访问分配在本节点上
+  if(!CpuAffinity::bindCurrentThread(cpus_)) {
+    LOG<<"EventLoopThread::threadFunc bind cpu failed, errno="<<errno;
+  }
   EventLoop loop;
+  if(callback_) {
+    callback_(&loop);
+  }
   {
     MutexLockGuard lock(mutex_);
     loop_ = &loop;
@@ -6,6 +6,9 @@
 #include "../muduo/thread/Mutex.h"
 #include "../muduo/thread/Thread.h"
 #include "../muduo/thread/Condition.h"
+#include "../muduo/thread/CpuAffinity.h"
+
+#include <functional>
 
 
 
@@ -15,10 +18,16 @@ class EventLoop;
 
 class EventLoopThread {
 public:
-  EventLoopThread();
+  //在新线程中、loop() 开始之前调用，用于设置该循环(忙轮询等)
+  typedef std::function<void(EventLoop*)> ThreadInitCallback;
+
+  explicit EventLoopThread(const ThreadInitCallback& cb = ThreadInitCallback());
   ~EventLoopThread();
   EventLoop* startLoop();
 
+  //新线程在创建 EventLoop 之前绑定到这些CPU，须在 startLoop() 之前设置
+  void setCpuSet(const CpuAffinity::CpuSet& cpus) { cpus_ = cpus; }
+
 private:
   void threadFunc();
 
@@ -27,6 +36,8 @@ private:
   Thread thread_;
   MutexLock mutex_;
   Condition cond_;
+  ThreadInitCallback callback_;
+  CpuAffinity::CpuSet cpus_;
 
 };
 }
@@ -5,17 +5,36 @@
 #include "EventLoopThread.h"
 
 
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
 
 
 
 using namespace muduo;
 
+namespace {
+
+//每个循环在哈希环上的虚节点数，越多分布越均匀
+const int kVirtualNodesPerLoop = 128;
+
+//splitmix64 的混合函数，把相近的输入(如同一网段的IP)打散
+size_t mixHash(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return static_cast<size_t>(x ^ (x >> 31));
+}
+
+}
+
 EventLoopThreadPool::EventLoopThreadPool(EventLoop* baseLoop)
   : baseLoop_(baseLoop),
     started_(false),
     numThreads_(0),
-    next_(0)
+    next_(0),
+    pinToPhysicalCores_(false),
+    loadBalance_(kRoundRobin)
 {
 
 }
@@ -24,15 +43,36 @@ EventLoopThreadPool::~EventLoopThreadPool() {
 
 }
 
-void EventLoopThreadPool::start() {
+void EventLoopThreadPool::setThreadNum(int numThreads) {
+  assert(!started_);
+  assert(numThreads >= 0);
+  numThreads_ = numThreads;
+}
+
+void EventLoopThreadPool::start(const ThreadInitCallback& cb) {
   assert(!started_);
   baseLoop_->assertInLoopThread();
   started_ = true;
 
+  if(pinToPhysicalCores_ && cpuSets_.empty()) {
+    cpuSets_ = CpuAffinity::spreadAcrossCores(numThreads_);
+  }
   for(int i=0;i<numThreads_;i++) {
-    auto t = std::make_unique<EventLoopThread>();
-    threads_.push_back(std::move(t));
+    auto t = std::make_unique<EventLoopThread>(cb);
+    if(!cpuSets_.empty()) {
+      t->setCpuSet(cpuSets_[i % cpuSets_.size()]);
+    }
     loops_.push_back(t->startLoop());
+    threads_.push_back(std::move(t));
+  }
+  for(size_t i=0;i<loops_.size();i++) {
+    for(int j=0;j<kVirtualNodesPerLoop;j++) {
+      ring_.emplace_back(mixHash((static_cast<uint64_t>(i) << 32) | j),static_cast<int>(i));
+    }
+  }
+  std::sort(ring_.begin(),ring_.end());
+  if(numThreads_ == 0 && cb) {
+    cb(baseLoop_);
   }
 }
 
@@ -49,6 +89,59 @@ EventLoop* EventLoopThreadPool::getNextLoop() {
   return loop;
 }
 
+EventLoop* EventLoopThreadPool::getLoop(size_t hashCode) {
+  baseLoop_->assertInLoopThread();
+  if(loops_.empty()) {
+    return baseLoop_;
+  }
+  switch(loadBalance_) {
+    case kLeastConnections:
+    case kLeastQueuedBytes: {
+      //从轮转位置开始找，负载相同时依然轮流分配
+      size_t n = loops_.size();
+      size_t best = next_;
+      int64_t bestLoad = INT64_MAX;
+      for(size_t k=0;k<n;k++) {
+        size_t i = (next_ + k) % n;
+        int64_t load = loadBalance_ == kLeastConnections ? loops_[i]->numConnections()
+                                                         : loops_[i]->queuedBytes();
+        if(load < bestLoad) {
+          bestLoad = load;
+          best = i;
+        }
+      }
+      next_ = static_cast<int>((best + 1) % n);
+      return loops_[best];
+    }
+    case kConsistentHash:
+      return getLoopForHash(hashCode);
+    case kRoundRobin:
+    default:
+      return getNextLoop();
+  }
+}
+
+EventLoop* EventLoopThreadPool::getLoopForHash(size_t hashCode) {
+  baseLoop_->assertInLoopThread();
+  if(ring_.empty()) {
+    return baseLoop_;
+  }
+  std::pair<size_t,int> key(mixHash(hashCode),-1);
+  auto it = std::lower_bound(ring_.begin(),ring_.end(),key);
+  if(it == ring_.end()) {
+    it = ring_.begin();
+  }
+  return loops_[it->second];
+}
+
+std::vector<EventLoop*> EventLoopThreadPool::getAllLoops() const {
+  assert(started_);
+  if(loops_.empty()) {
+    return std::vector<EventLoop*>(1, baseLoop_);
+  }
+  return loops_;
+}
+
 
 
 
@@ -6,9 +6,11 @@
 
 
 
+#include <functional>
+#include <memory>
 #include <vector>
 
-#include <memory>
+#include "thread/CpuAffinity.h"
 
 
 
@@ -20,9 +22,34 @@ class EventLoopThreadPool {
 public:
   EventLoopThreadPool(EventLoop * baseLoop);
   ~EventLoopThreadPool();
-  void start();
-  void setThreadNum(int numThreads){}
+  typedef std::function<void(EventLoop*)> ThreadInitCallback;
+  //cb 在每个IO线程中、循环开始之前调用；没有IO线程时对 baseLoop 调用
+  void start(const ThreadInitCallback& cb = ThreadInitCallback());
+  //新连接分配到哪个IO线程
+  enum LoadBalance {
+    kRoundRobin,        //轮流分配
+    kLeastConnections,  //连接数最少的循环
+    kLeastQueuedBytes,  //输出缓冲区积压字节数最少的循环
+    kConsistentHash,    //按 hashCode 一致性哈希，同一来源总是落到同一个循环
+  };
+
+  void setThreadNum(int numThreads);
+  void setLoadBalance(LoadBalance lb) { loadBalance_ = lb; }
+  LoadBalance loadBalance() const { return loadBalance_; }
+
+  //按 setLoadBalance 选择的策略取一个循环，hashCode 只在 kConsistentHash 时使用
+  EventLoop* getLoop(size_t hashCode);
   EventLoop* getNextLoop();
+  //一致性哈希：IO线程数不变时同一个 hashCode 总是得到同一个循环
+  EventLoop* getLoopForHash(size_t hashCode);
+
+  //第 i 个IO线程绑定到 cpuSets[i % size]，须在 start() 之前设置；为空表示不绑核
+  void setCpuSets(const std::vector<CpuAffinity::CpuSet>& cpuSets) { cpuSets_ = cpuSets; }
+  //每个IO线程各绑一个物理核(先铺满物理核再用超线程，在NUMA节点间交错)
+  void pinToPhysicalCores() { pinToPhysicalCores_ = true; }
+
+  //所有IO线程的循环，没有IO线程时只有 baseLoop，须在 start() 之后调用
+  std::vector<EventLoop*> getAllLoops() const;
 
 private:
   EventLoop* baseLoop_;
@@ -31,6 +58,11 @@ private:
   int next_;
   std::vector<std::unique_ptr<EventLoopThread>> threads_;
   std::vector<EventLoop*> loops_;
+  std::vector<CpuAffinity::CpuSet> cpuSets_;
+  bool pinToPhysicalCores_;
+  LoadBalance loadBalance_;
+  //哈希环，(虚节点哈希值, loops_ 下标) 按哈希值排序
+  std::vector<std::pair<size_t,int>> ring_;
 
 
 };
@@ -4,28 +4,34 @@
 #include "../muduo/log/base/Logging.h"
 #include "Channel.h"
 #include "TimeStamp.h"
+#include <cassert>
 #include <functional>
 using namespace muduo;
 
-muduo::Poller::Poller(EventLoop* loop) :ownerLoop_(loop){}
+PollPoller::PollPoller(EventLoop* loop) :Poller(loop){}
 
-muduo:: Poller::~Poller() = default;
+PollPoller::~PollPoller() = default;
 
-Timestamp Poller::poll(int timeoutMs,muduo::Poller::ChannelList* activeChannels) {
-  int numEvents = ::poll(&*pollfds_.begin(),pollfds_.size(),timeoutMs);
-  Timestamp now;
+Timestamp PollPoller::poll(int timeoutMs,ChannelList* activeChannels) {
+  int numEvents = ::poll(pollfds_.data(),pollfds_.size(),timeoutMs);
+  Timestamp now = Timestamp::now();
+  if(numEvents >= 0) {
+    recordWakeup(numEvents);
+  }
   if(numEvents>0) {
     LOG<<numEvents<<" events happended";
     fillActiveChannels(numEvents,activeChannels);
   }else if(numEvents == 0) {
-    LOG<<" nothing happended";
+    if(timeoutMs != 0) {  //忙轮询时不记录
+      LOG<<" nothing happended";
+    }
   }else {
-    LOG<<"Poller::poll()";
+    LOG<<"PollPoller::poll()";
   }
   return now;
 }
 
-void Poller::fillActiveChannels(int numEvents,
+void PollPoller::fillActiveChannels(int numEvents,
                                 ChannelList* activeChannels) const {
 for(auto pfd = pollfds_.begin();pfd!=pollfds_.end()&&numEvents>0;++pfd) {
   if(pfd->revents>0) {
@@ -41,7 +47,7 @@ for(auto pfd = pollfds_.begin();pfd!=pollfds_.end()&&numEvents>0;++pfd) {
 }
 
 
-void Poller::updateChannel(Channel* channel)
+void PollPoller::updateChannel(Channel* channel)
 {
   assertInLoopThread();
   LOG << "fd = " << channel->fd() << " events = " << channel->events();
@@ -73,7 +79,7 @@ void Poller::updateChannel(Channel* channel)
   }
 }
 
-void Poller::removeChannel(Channel* channel)
+void PollPoller::removeChannel(Channel* channel)
 {
   assertInLoopThread();
   LOG << "fd = " << channel->fd();
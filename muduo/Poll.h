@@ -4,10 +4,9 @@
 #define POLL_H
 #include <sys/poll.h>
 
-#include <map>
 #include <vector>
 
-#include "EventLoop.h"
+#include "Poller.h"
 #include "TimeStamp.h"
 struct pollfd;
 namespace  muduo {
@@ -17,36 +16,28 @@ namespace  muduo {
 
 //IO Multiplexing with poll
 
-class Poller {
+class PollPoller : public Poller {
 public:
-  typedef std::vector<Channel*> ChannelList;
-  explicit Poller(EventLoop* loop);
-  ~Poller();
+  explicit PollPoller(EventLoop* loop);
+  ~PollPoller() override;
 
   //Polls the IO events
   //Must be called in the loop thread
-  Timestamp poll(int timeoutMs,ChannelList* activeChannels);
+  Timestamp poll(int timeoutMs,ChannelList* activeChannels) override;
 
   //Changes the interested IO events
   //Must be called int the loop thread
-  void updateChannel(Channel* channel);
+  void updateChannel(Channel* channel) override;
 
-  void removeChannel(Channel* channel);
-
-  void assertInLoopThread() {
-
-  }
+  void removeChannel(Channel* channel) override;
 
 private:
   void fillActiveChannels(int numEvents,ChannelList* activeChannels) const;
 
 
   typedef std::vector<struct pollfd> PollFdList;
-  typedef std::map<int ,Channel*> ChannelMap;
 
-  EventLoop* ownerLoop_;
   PollFdList pollfds_;
-  ChannelMap channels_;
 
 };
 
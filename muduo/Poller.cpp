@@ -0,0 +1,49 @@
+
+
+#include "Poller.h"
+
+#include <cstdlib>
+
+#include "Channel.h"
+#include "EPoll.h"
+#include "EventLoop.h"
+#include "Poll.h"
+
+using namespace muduo;
+
+Poller::Poller(EventLoop* loop) :ownerLoop_(loop){}
+
+Poller::~Poller() = default;
+
+bool Poller::hasChannel(Channel* channel) const {
+  assertInLoopThread();
+  auto it = channels_.find(channel->fd());
+  return it != channels_.end() && it->second == channel;
+}
+
+void Poller::recordWakeup(int numEvents) {
+  ++stats_.wakeups;
+  stats_.eventsReturned += numEvents;
+  if(numEvents > stats_.maxEventsPerWakeup) {
+    stats_.maxEventsPerWakeup = numEvents;
+  }
+  int bucket = 0;
+  for(int n = numEvents;n > 0 && bucket < kHistogramBuckets - 1;n >>= 1) {
+    ++bucket;
+  }
+  ++stats_.eventsHistogram[bucket];
+}
+
+void Poller::assertInLoopThread() const {
+  ownerLoop_->assertInLoopThread();
+}
+
+Poller* Poller::newPoller(EventLoop* loop,Backend backend) {
+  if(backend == kDefaultBackend) {
+    backend = ::getenv("MUDUO_USE_POLL") ? kPollBackend : kEPollBackend;
+  }
+  if(backend == kPollBackend) {
+    return new PollPoller(loop);
+  }
+  return new EPoller(loop);
+}
@@ -0,0 +1,86 @@
+
+
+#ifndef POLLER_H
+#define POLLER_H
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "TimeStamp.h"
+
+namespace muduo {
+
+class Channel;
+class EventLoop;
+
+//IO Multiplexing 的抽象接口
+//该类不拥有Channel对象的所有权，具体实现见 Poll.h(poll) 和 EPoll.h(epoll)
+
+class Poller {
+public:
+  typedef std::vector<Channel*> ChannelList;
+
+  //后端选择，kDefaultBackend 时默认使用epoll，
+  //设置了环境变量 MUDUO_USE_POLL 时退回 poll
+  enum Backend { kDefaultBackend, kPollBackend, kEPollBackend };
+
+  static const int kHistogramBuckets = 16;
+
+  //统计信息，只在循环线程中更新
+  struct Stats {
+    uint64_t ctlIssued = 0;   //实际发出的 epoll_ctl 次数
+    uint64_t ctlElided = 0;   //被合并或因掩码未变而省略的次数
+
+    uint64_t wakeups = 0;         //poll 返回的次数(不含出错)
+    uint64_t eventsReturned = 0;  //累计返回的就绪事件数
+    int maxEventsPerWakeup = 0;   //单次返回的最大就绪事件数
+    //每次唤醒返回事件数的分布：桶0 为0个，桶i(i>0) 为 [2^(i-1), 2^i)，最后一个桶不封顶
+    uint64_t eventsHistogram[kHistogramBuckets] = {};
+
+    size_t eventListSize = 0;     //当前事件数组大小(仅epoll)
+    uint64_t eventListGrows = 0;
+    uint64_t eventListShrinks = 0;
+  };
+
+  explicit Poller(EventLoop* loop);
+  virtual ~Poller();
+
+  //Polls the IO events
+  //Must be called in the loop thread
+  virtual Timestamp poll(int timeoutMs,ChannelList* activeChannels) = 0;
+
+  //Changes the interested IO events
+  //Must be called in the loop thread
+  virtual void updateChannel(Channel* channel) = 0;
+
+  //Remove the channel, when it destructs
+  //Must be called in the loop thread
+  virtual void removeChannel(Channel* channel) = 0;
+
+  virtual bool hasChannel(Channel* channel) const;
+
+  //单次 poll 最多返回的事件数上限，仅对epoll有意义，必须在循环线程中调用
+  virtual void setMaxEventsPerPoll(int /*maxEvents*/) {}
+
+  static Poller* newPoller(EventLoop* loop,Backend backend);
+
+  void assertInLoopThread() const;
+
+  const Stats& stats() const { return stats_; }
+
+protected:
+  //记录一次 poll 返回的事件数
+  void recordWakeup(int numEvents);
+
+  typedef std::map<int,Channel*> ChannelMap;
+  ChannelMap channels_;  //存储每个文件描述符对应的Channel
+  Stats stats_;
+
+private:
+  EventLoop* ownerLoop_;
+};
+
+}
+
+#endif //POLLER_H
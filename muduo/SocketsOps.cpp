@@ -82,9 +82,9 @@ void sockets::bindOrDie(int sockfd, const struct sockaddr_in& addr)
   }
 }
 
-void sockets::listenOrDie(int sockfd)
+void sockets::listenOrDie(int sockfd, int backlog)
 {
-  int ret = ::listen(sockfd, SOMAXCONN);
+  int ret = ::listen(sockfd, backlog);
   if (ret < 0)
   {
     LOG << "sockets::listenOrDie";
@@ -104,7 +104,10 @@ int sockets::accept(int sockfd, struct sockaddr_in* addr)
   if (connfd < 0)
   {
     int savedErrno = errno;
-    LOG << "Socket::accept";
+    if (savedErrno != EAGAIN)  // 批量 accept 时每次都以 EAGAIN 结束
+    {
+      LOG << "Socket::accept";
+    }
     switch (savedErrno)
     {
       case EAGAIN:
@@ -114,7 +117,6 @@ int sockets::accept(int sockfd, struct sockaddr_in* addr)
       case EPERM:
       case EMFILE: // per-process lmit of open file desctiptor ???
         // expected errors
-        errno = savedErrno;
         break;
       case EBADF:
       case EFAULT:
@@ -131,6 +133,7 @@ int sockets::accept(int sockfd, struct sockaddr_in* addr)
         LOG << "unknown error of ::accept " << savedErrno;
         break;
     }
+    errno = savedErrno;  // 调用方根据 errno 决定是否继续 accept，日志不能改掉它
   }
   return connfd;
 }
@@ -47,7 +47,7 @@ int createNonblockingOrDie();
 
 int  connect(int sockfd, const struct sockaddr_in& addr);
 void bindOrDie(int sockfd, const struct sockaddr_in& addr);
-void listenOrDie(int sockfd);
+void listenOrDie(int sockfd, int backlog = SOMAXCONN);
 int  accept(int sockfd, struct sockaddr_in* addr);
 void close(int sockfd);
 void shutdownWrite(int sockfd);
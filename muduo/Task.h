@@ -0,0 +1,145 @@
+
+
+#ifndef TASK_H
+#define TASK_H
+
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace muduo {
+
+/// 只能移动的 void() 可调用对象，用来代替 std::function<void()> 投递到 EventLoop
+///
+/// 不超过 kInlineSize 字节且移动构造不抛异常的闭包直接存放在对象内部，
+/// 不会分配内存，例如 std::bind(&TcpConnection::sendInLoop, conn, message)；
+/// 更大的闭包才退回到堆上。
+/// 因为不要求可复制，闭包可以按右值移动进来，捕获的数据不会被拷贝。
+class Task {
+public:
+  static const size_t kInlineSize = 96;
+
+  Task() noexcept : ops_(nullptr) {}
+  Task(std::nullptr_t) noexcept : ops_(nullptr) {}
+
+  template<typename F,
+           typename = typename std::enable_if<
+               !std::is_same<typename std::decay<F>::type, Task>::value>::type>
+  Task(F&& f) : ops_(nullptr) {
+    typedef typename std::decay<F>::type Fn;
+    construct<Fn>(std::forward<F>(f), std::integral_constant<bool, fitsInline<Fn>()>());
+  }
+
+  Task(Task&& other) noexcept : ops_(other.ops_) {
+    if(ops_) {
+      ops_->move(&storage_,&other.storage_);
+      other.ops_ = nullptr;
+    }
+  }
+
+  Task& operator=(Task&& other) noexcept {
+    if(this != &other) {
+      reset();
+      if(other.ops_) {
+        other.ops_->move(&storage_,&other.storage_);
+        ops_ = other.ops_;
+        other.ops_ = nullptr;
+      }
+    }
+    return *this;
+  }
+
+  Task& operator=(std::nullptr_t) noexcept {
+    reset();
+    return *this;
+  }
+
+  Task(const Task&) = delete;
+  Task& operator=(const Task&) = delete;
+
+  ~Task() { reset(); }
+
+  void operator()() {
+    assert(ops_);
+    ops_->invoke(&storage_);
+  }
+
+  explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+  //闭包是否存放在对象内部(没有分配内存)
+  bool isInline() const noexcept { return ops_ != nullptr && ops_->isInline; }
+
+private:
+  struct Ops {
+    void (*invoke)(void* storage);
+    void (*move)(void* dst,void* src);  //移动到dst并析构src
+    void (*destroy)(void* storage);
+    bool isInline;
+  };
+
+  template<typename Fn>
+  static constexpr bool fitsInline() {
+    return sizeof(Fn) <= kInlineSize
+        && alignof(Fn) <= alignof(std::max_align_t)
+        && std::is_nothrow_move_constructible<Fn>::value;
+  }
+
+  template<typename Fn>
+  struct InlineOps {
+    static Fn* get(void* p) { return static_cast<Fn*>(p); }
+    static void invoke(void* p) { (*get(p))(); }
+    static void move(void* dst,void* src) {
+      new (dst) Fn(std::move(*get(src)));
+      get(src)->~Fn();
+    }
+    static void destroy(void* p) { get(p)->~Fn(); }
+    static const Ops kOps;
+  };
+
+  template<typename Fn>
+  struct HeapOps {
+    static Fn*& get(void* p) { return *static_cast<Fn**>(p); }
+    static void invoke(void* p) { (*get(p))(); }
+    static void move(void* dst,void* src) { new (dst) Fn*(get(src)); }
+    static void destroy(void* p) { delete get(p); }
+    static const Ops kOps;
+  };
+
+  template<typename Fn,typename F>
+  void construct(F&& f,std::true_type /* inline */) {
+    new (&storage_) Fn(std::forward<F>(f));
+    ops_ = &InlineOps<Fn>::kOps;
+  }
+
+  template<typename Fn,typename F>
+  void construct(F&& f,std::false_type /* heap */) {
+    new (&storage_) Fn*(new Fn(std::forward<F>(f)));
+    ops_ = &HeapOps<Fn>::kOps;
+  }
+
+  void reset() noexcept {
+    if(ops_) {
+      ops_->destroy(&storage_);
+      ops_ = nullptr;
+    }
+  }
+
+  const Ops* ops_;
+  typename std::aligned_storage<kInlineSize,alignof(std::max_align_t)>::type storage_;
+};
+
+template<typename Fn>
+const Task::Ops Task::InlineOps<Fn>::kOps = {
+  &Task::InlineOps<Fn>::invoke,&Task::InlineOps<Fn>::move,&Task::InlineOps<Fn>::destroy,true
+};
+
+template<typename Fn>
+const Task::Ops Task::HeapOps<Fn>::kOps = {
+  &Task::HeapOps<Fn>::invoke,&Task::HeapOps<Fn>::move,&Task::HeapOps<Fn>::destroy,false
+};
+
+}
+
+#endif //TASK_H
@@ -3,36 +3,88 @@
 #include "EventLoop.h"
 #include "InetAddress.h"
 #include "SocketsOps.h"
+#include "log/base/Logging.h"
+
+#include <cassert>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
 
 
 using namespace muduo;
 
-Acceptor::Acceptor(EventLoop* loop,const InetAddress& listenAddr)
+Acceptor::Acceptor(EventLoop* loop,const InetAddress& listenAddr,bool reuseport)
   :loop_(loop),
    acceptSocket_(sockets::createNonblockingOrDie()),
    acceptChannel_(loop,acceptSocket_.fd()),
-   listening_(false)
+   listening_(false),
+   idleFd_(::open("/dev/null",O_RDONLY | O_CLOEXEC))
 {
+  assert(idleFd_ >= 0);
   acceptSocket_.setReuseAddr(true);
+  acceptSocket_.setReusePort(reuseport);
   acceptSocket_.bindAddress(listenAddr);
   acceptChannel_.setWReadCallback(std::bind(&Acceptor::handleRead,this));
 }
+Acceptor::~Acceptor() {
+  //监听过的 Channel 注册在 loop_ 上，须在 loop_ 所在线程析构
+  if(listening_) {
+    acceptChannel_.disableAll();
+    loop_->removeChannel(&acceptChannel_);
+  }
+  ::close(idleFd_);
+}
+
+void Acceptor::setListenOptions(const ListenOptions& options) {
+  assert(!listening_);
+  options_ = options;
+  setAcceptBatch(options.acceptBatch);
+}
+
 void Acceptor::listen() {
   loop_->assertInLoopThread();
   listening_ = true;
-  acceptSocket_.listen();
+  if(options_.deferAcceptSecs > 0 && !acceptSocket_.setDeferAccept(options_.deferAcceptSecs)) {
+    LOG<<"Acceptor::listen TCP_DEFER_ACCEPT failed, errno="<<errno;
+  }
+  if(options_.fastOpenQueueLen > 0 && !acceptSocket_.setFastOpen(options_.fastOpenQueueLen)) {
+    LOG<<"Acceptor::listen TCP_FASTOPEN failed, errno="<<errno;
+  }
+  acceptSocket_.listen(options_.backlog);
   acceptChannel_.enableReading();
 }
 void Acceptor::handleRead() {
   loop_->assertInLoopThread();
-  InetAddress peerAddr(0);
-  int connfd  = acceptSocket_.accept(&peerAddr);
-  if(connfd>=0) {
-    if(newConnectionCallback_) {
-      newConnectionCallback_(connfd,peerAddr);
-    }else {
-      sockets::close(connfd);
+  //一次唤醒接受多个连接，直到 EAGAIN、fd 耗尽或用完批量
+  for(int i = 0; i < options_.acceptBatch; ++i) {
+    InetAddress peerAddr(0);
+    int connfd  = acceptSocket_.accept(&peerAddr);
+    if(connfd>=0) {
+      if(newConnectionCallback_) {
+        newConnectionCallback_(connfd,peerAddr);
+      }else {
+        sockets::close(connfd);
+      }
+      continue;
+    }
+    const int savedErrno = errno;  //sockets::accept 保证返回时 errno 是 accept 的错误码
+    if(savedErrno == EAGAIN || savedErrno == EWOULDBLOCK) {
+      break;  //监听队列已空
+    }else if(savedErrno == EMFILE || savedErrno == ENFILE) {
+      //腾出空闲fd，接受后立即关闭，让对端尽快得知而不是一直挂在监听队列里
+      LOG<<"Acceptor::handleRead out of file descriptors, shedding a connection";
+      ::close(idleFd_);
+      idleFd_ = ::accept(acceptSocket_.fd(),NULL,NULL);
+      if(idleFd_ >= 0) {
+        ::close(idleFd_);
+      }
+      idleFd_ = ::open("/dev/null",O_RDONLY | O_CLOEXEC);
+      break;  //fd 仍然紧张，剩下的连接等下次可读时再处理
+    }else if(savedErrno == EBADF || savedErrno == EINVAL || savedErrno == ENOTSOCK
+             || savedErrno == EOPNOTSUPP || savedErrno == EFAULT) {
+      break;  //监听套接字本身出了问题，再试也是同样的错误
     }
+    //ECONNABORTED、EINTR 等只影响这一个连接(sockets::accept 已记录)，继续处理队列中的连接
   }
 }
 
@@ -5,6 +5,7 @@
 #include <functional>
 
 #include "Channel.h"
+#include "ListenOptions.h"
 #include "Socket.h"
 
 using namespace muduo;
@@ -16,13 +17,22 @@ class Acceptor {
 public:
   typedef std::function<void (int sockfd,
                               const InetAddress&)> NewConnectionCallback;
-  Acceptor(EventLoop* loop,const InetAddress& listenAddr);
+  //reuseport 为 true 时设置 SO_REUSEPORT，可以在多个循环上各建一个 Acceptor 监听同一地址
+  Acceptor(EventLoop* loop,const InetAddress& listenAddr,bool reuseport = false);
+  ~Acceptor();
   void setNewConnectionCallback(const NewConnectionCallback& cb) {
-
+    newConnectionCallback_ = cb;
   }
   bool listening()const{return listening_;}
+  EventLoop* getLoop()const{return loop_;}
   void listen();
 
+  //每次可读事件最多 accept 的连接数，默认 kDefaultAcceptBatch
+  void setAcceptBatch(int n) { options_.acceptBatch = n > 0 ? n : 1; }
+  static const int kDefaultAcceptBatch = ListenOptions::kDefaultAcceptBatch;
+  //须在 listen() 之前设置
+  void setListenOptions(const ListenOptions& options);
+
 private:
   void handleRead();
 
@@ -31,6 +41,10 @@ private:
   Channel acceptChannel_;
   NewConnectionCallback newConnectionCallback_;
   bool listening_;
+  ListenOptions options_;
+  //预留的空闲fd，文件描述符耗尽(EMFILE)时关掉它腾出一个fd来接受并立即关闭连接，
+  //否则连接一直留在监听队列里，水平触发下监听套接字会一直可读导致忙循环
+  int idleFd_;
 };
 
 
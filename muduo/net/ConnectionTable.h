@@ -0,0 +1,95 @@
+#ifndef CONNECTIONTABLE_H
+#define CONNECTIONTABLE_H
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "TcpConnection.h"
+
+namespace muduo {
+
+///
+/// TcpServer 的连接表：连接按 64 位 id 存放在连续的槽位数组中
+/// id 的低 32 位是槽位下标，高 32 位是该槽位的代数，槽位复用时代数加一，
+/// 旧 id 因此不会误指向新连接。插入、查找和删除都是 O(1)，不分配字符串
+/// 不是线程安全的，由调用者加锁
+///
+class ConnectionTable {
+public:
+  typedef uint64_t Id;
+
+  ConnectionTable() : size_(0) {}
+
+  //分配一个新 id，随后用 set() 放入连接
+  Id allocate() {
+    uint32_t slot;
+    if(!freeSlots_.empty()) {
+      slot = freeSlots_.back();
+      freeSlots_.pop_back();
+    }else {
+      slot = static_cast<uint32_t>(slots_.size());
+      slots_.push_back(Slot());
+    }
+    ++size_;
+    return makeId(slots_[slot].generation,slot);
+  }
+
+  void set(Id id,const TcpConnectionPtr& conn) {
+    Slot* s = find(id);
+    assert(s != nullptr);
+    s->conn = conn;
+  }
+
+  TcpConnectionPtr get(Id id) const {
+    const Slot* s = const_cast<ConnectionTable*>(this)->find(id);
+    return s ? s->conn : TcpConnectionPtr();
+  }
+
+  //删除成功返回 true，id 已失效时返回 false
+  bool erase(Id id) {
+    Slot* s = find(id);
+    if(s == nullptr) {
+      return false;
+    }
+    s->conn.reset();
+    ++s->generation;
+    if(s->generation == 0) {
+      s->generation = 1;  //保证 id 不为 0
+    }
+    freeSlots_.push_back(slotOf(id));
+    --size_;
+    return true;
+  }
+
+  size_t size() const { return size_; }
+
+private:
+  struct Slot {
+    Slot() : generation(1) {}
+    TcpConnectionPtr conn;
+    uint32_t generation;
+  };
+
+  static Id makeId(uint32_t generation,uint32_t slot) {
+    return (static_cast<Id>(generation) << 32) | slot;
+  }
+  static uint32_t slotOf(Id id) { return static_cast<uint32_t>(id); }
+  static uint32_t generationOf(Id id) { return static_cast<uint32_t>(id >> 32); }
+
+  Slot* find(Id id) {
+    uint32_t slot = slotOf(id);
+    if(slot >= slots_.size() || slots_[slot].generation != generationOf(id)) {
+      return nullptr;
+    }
+    return &slots_[slot];
+  }
+
+  std::vector<Slot> slots_;
+  std::vector<uint32_t> freeSlots_;
+  size_t size_;
+};
+
+}
+
+#endif //CONNECTIONTABLE_H
@@ -0,0 +1,27 @@
+#ifndef LISTENOPTIONS_H
+#define LISTENOPTIONS_H
+
+#include <sys/socket.h>
+
+namespace muduo {
+
+//监听套接字的选项，由 TcpServer 传给它的每个 Acceptor
+struct ListenOptions {
+  static const int kDefaultAcceptBatch = 64;
+
+  ListenOptions()
+    : backlog(SOMAXCONN),
+      deferAcceptSecs(0),
+      fastOpenQueueLen(0),
+      acceptBatch(kDefaultAcceptBatch)
+  {}
+
+  int backlog;           //listen() 的 backlog，实际上限还受 net.core.somaxconn 限制
+  int deferAcceptSecs;   //TCP_DEFERACCEPT：握手完成后最多等这么多秒，客户端发来数据才唤醒 accept；0 表示关闭
+  int fastOpenQueueLen;  //TCP_FASTOPEN：等待完成握手的 TFO 请求队列长度；0 表示关闭
+  int acceptBatch;       //每次可读事件最多 accept 的连接数
+};
+
+}
+
+#endif //LISTENOPTIONS_H
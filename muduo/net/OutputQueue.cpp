@@ -0,0 +1,132 @@
+#include "OutputQueue.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+using namespace muduo;
+
+OutputQueue::OutputQueue()
+  : pool_(nullptr),
+    head_(nullptr),
+    tail_(nullptr),
+    size_(0)
+{
+}
+
+OutputQueue::OutputQueue(OutputQueue&& other) noexcept
+  : pool_(other.pool_),
+    head_(other.head_),
+    tail_(other.tail_),
+    size_(other.size_)
+{
+  other.head_ = nullptr;
+  other.tail_ = nullptr;
+  other.size_ = 0;
+}
+
+OutputQueue::~OutputQueue() {
+  //析构可能发生在任意线程，循环甚至已经不在了，所以不归还给 pool_
+  while(head_ != nullptr) {
+    Chunk* next = head_->next;
+    delete head_;
+    head_ = next;
+  }
+}
+
+Chunk* OutputQueue::allocateChunk() {
+  if(pool_ != nullptr) {
+    return pool_->allocate();
+  }
+  Chunk* chunk = new Chunk;
+  chunk->next = nullptr;
+  chunk->readIndex = 0;
+  chunk->writeIndex = 0;
+  return chunk;
+}
+
+void OutputQueue::releaseChunk(Chunk* chunk) {
+  if(pool_ != nullptr) {
+    pool_->release(chunk);
+  }else {
+    delete chunk;
+  }
+}
+
+void OutputQueue::append(const char* data, size_t len) {
+  size_ += len;
+  while(len > 0) {
+    if(tail_ == nullptr || tail_->writableBytes() == 0) {
+      Chunk* chunk = allocateChunk();
+      if(tail_ == nullptr) {
+        head_ = chunk;
+      }else {
+        tail_->next = chunk;
+      }
+      tail_ = chunk;
+    }
+    size_t n = std::min(len, tail_->writableBytes());
+    memcpy(tail_->data + tail_->writeIndex, data, n);
+    tail_->writeIndex += n;
+    data += n;
+    len -= n;
+  }
+}
+
+void OutputQueue::splice(OutputQueue* other) {
+  if(other->head_ == nullptr) {
+    return;
+  }
+  if(tail_ == nullptr) {
+    head_ = other->head_;
+  }else {
+    tail_->next = other->head_;
+  }
+  tail_ = other->tail_;
+  size_ += other->size_;
+  other->head_ = nullptr;
+  other->tail_ = nullptr;
+  other->size_ = 0;
+}
+
+int OutputQueue::peek(struct iovec* vec, int maxIov) const {
+  int n = 0;
+  for(Chunk* chunk = head_; chunk != nullptr && n < maxIov; chunk = chunk->next) {
+    if(chunk->readableBytes() == 0) {
+      continue;
+    }
+    vec[n].iov_base = chunk->data + chunk->readIndex;
+    vec[n].iov_len = chunk->readableBytes();
+    ++n;
+  }
+  return n;
+}
+
+void OutputQueue::retrieve(size_t len) {
+  assert(len <= size_);
+  size_ -= len;
+  while(len > 0) {
+    assert(head_ != nullptr);
+    size_t n = std::min(len, head_->readableBytes());
+    head_->readIndex += n;
+    len -= n;
+    if(head_->readableBytes() == 0) {
+      Chunk* next = head_->next;
+      releaseChunk(head_);
+      head_ = next;
+    }
+  }
+  if(head_ == nullptr) {
+    tail_ = nullptr;
+  }
+}
+
+void OutputQueue::clear() {
+  while(head_ != nullptr) {
+    Chunk* next = head_->next;
+    releaseChunk(head_);
+    head_ = next;
+  }
+  tail_ = nullptr;
+  size_ = 0;
+}
@@ -0,0 +1,58 @@
+#ifndef OUTPUTQUEUE_H
+#define OUTPUTQUEUE_H
+
+#include <string>
+
+#include <sys/uio.h>
+
+#include "../ChunkPool.h"
+
+namespace muduo {
+
+///
+/// TcpConnection 的输出队列：由定长 Chunk 组成的链表，用 writev 一次写出多个块
+/// 追加大量数据时只是多挂几个块，不会像 Buffer 那样整体扩容再搬移；
+/// 写完的块立即还给所属循环的 ChunkPool，空闲连接不占输出内存
+/// 与所在的 TcpConnection 一样只能在循环线程中使用
+///
+class OutputQueue {
+public:
+  OutputQueue();
+  ~OutputQueue();
+  OutputQueue(OutputQueue&& other) noexcept;
+
+  OutputQueue(const OutputQueue&) = delete;
+  OutputQueue& operator=(const OutputQueue&) = delete;
+  OutputQueue& operator=(OutputQueue&&) = delete;
+
+  //块从 pool 分配并归还给它；未设置时直接 new/delete
+  void setPool(ChunkPool* pool) { pool_ = pool; }
+
+  size_t readableBytes() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  void append(const char* data, size_t len);
+  void append(const std::string& str) { append(str.data(), str.size()); }
+  //把 other 的全部数据接到末尾，只移动块，不拷贝
+  void splice(OutputQueue* other);
+
+  //用队首的数据填充至多 maxIov 个 iovec，返回个数
+  int peek(struct iovec* vec, int maxIov) const;
+  //丢弃队首 len 字节，写完的块归还
+  void retrieve(size_t len);
+  //丢弃全部数据
+  void clear();
+
+private:
+  Chunk* allocateChunk();
+  void releaseChunk(Chunk* chunk);
+
+  ChunkPool* pool_;
+  Chunk* head_;
+  Chunk* tail_;
+  size_t size_;
+};
+
+}
+
+#endif //OUTPUTQUEUE_H
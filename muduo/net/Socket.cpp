@@ -2,6 +2,7 @@
 #include "Socket.h"
 #include "InetAddress.h"
 #include "SocketsOps.h"
+#include "log/base/Logging.h"
 
 #include <netinet/in.h>
 #include <netinet/tcp.h>
@@ -16,8 +17,8 @@ void Socket::bindAddress(const InetAddress& addr) {
   sockets::bindOrDie(sockfd_,addr.getSockAddrInet());
 }
 
-void Socket::listen() {
-  sockets::listenOrDie(sockfd_);
+void Socket::listen(int backlog) {
+  sockets::listenOrDie(sockfd_,backlog);
 }
 
 int Socket::accept(InetAddress* peeraddr) {
@@ -37,6 +38,20 @@ void Socket::setReuseAddr(bool on) {
 
 }
 
+void Socket::setReusePort(bool on) {
+#ifdef SO_REUSEPORT
+  int optval = on?1:0;
+  int ret = ::setsockopt(sockfd_,SOL_SOCKET,SO_REUSEPORT,&optval,sizeof(optval));
+  if(ret < 0 && on) {
+    LOG<<"SO_REUSEPORT failed.";
+  }
+#else
+  if(on) {
+    LOG<<"SO_REUSEPORT is not supported.";
+  }
+#endif
+}
+
 void Socket::shutdownWrite()
 {
   sockets::shutdownWrite(sockfd_);
@@ -50,6 +65,62 @@ void Socket::setTcpNoDelay(bool on)
   // FIXME CHECK
 }
 
+bool Socket::setDeferAccept(int secs)
+{
+#ifdef TCP_DEFER_ACCEPT
+  return ::setsockopt(sockfd_, IPPROTO_TCP, TCP_DEFER_ACCEPT,
+                      &secs, sizeof secs) == 0;
+#else
+  (void)secs;
+  return false;
+#endif
+}
+
+bool Socket::setFastOpen(int queueLen)
+{
+#ifdef TCP_FASTOPEN
+  return ::setsockopt(sockfd_, IPPROTO_TCP, TCP_FASTOPEN,
+                      &queueLen, sizeof queueLen) == 0;
+#else
+  (void)queueLen;
+  return false;
+#endif
+}
+
+bool Socket::setZeroCopy(bool on)
+{
+#ifdef SO_ZEROCOPY
+  int optval = on ? 1 : 0;
+  return ::setsockopt(sockfd_, SOL_SOCKET, SO_ZEROCOPY,
+                      &optval, sizeof optval) == 0;
+#else
+  (void)on;
+  return false;
+#endif
+}
+
+bool Socket::setBusyPoll(int usec, bool prefer)
+{
+#ifdef SO_BUSY_POLL
+  if(::setsockopt(sockfd_, SOL_SOCKET, SO_BUSY_POLL,
+                  &usec, sizeof usec) < 0) {
+    return false;
+  }
+#ifdef SO_PREFER_BUSY_POLL
+  int optval = prefer ? 1 : 0;
+  if(::setsockopt(sockfd_, SOL_SOCKET, SO_PREFER_BUSY_POLL,
+                  &optval, sizeof optval) < 0) {
+    return !prefer;
+  }
+#endif
+  return true;
+#else
+  (void)usec;
+  (void)prefer;
+  return false;
+#endif
+}
+
 
 
 
@@ -14,15 +14,27 @@ public:
 
   int fd() const {return sockfd_;}
   void bindAddress(const InetAddress& localddr);
-  void listen();
+  void listen(int backlog);
 
   int accept(InetAddress* peeraddr);
 
   void setReuseAddr(bool on);
+  //SO_REUSEPORT：多个套接字绑定同一端口，由内核在它们之间分配新连接
+  void setReusePort(bool on);
 
   void shutdownWrite();
 
   void setTcpNoDelay(bool on);
+
+  //TCP_DEFERACCEPT / TCP_FASTOPEN，用于监听套接字，不支持或失败时返回 false
+  bool setDeferAccept(int secs);
+  bool setFastOpen(int queueLen);
+  //SO_ZEROCOPY，之后才能用 MSG_ZEROCOPY 发送
+  bool setZeroCopy(bool on);
+
+  //SO_BUSY_POLL(/SO_PREFER_BUSY_POLL)：内核在收包时忙等 usec 微秒，
+  //需要 CAP_NET_ADMIN 才能调大超过 net.core.busy_read，失败返回 false
+  bool setBusyPoll(int usec, bool prefer);
 private:
   const int sockfd_;
 };
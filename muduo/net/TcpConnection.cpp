@@ -3,29 +3,168 @@
 #include "../log/base/Logging.h"
 #include "../Channel.h"
 #include "../EventLoop.h"
+#include "../TimerId.h"
 #include "Socket.h"
 #include "../SocketsOps.h"
 
 #include <functional>  // 替换 boost::bind
+#include <algorithm>
 #include <cerrno>
+#include <cinttypes>
+#include <chrono>
 #include <cstdio>
+#include <fcntl.h>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <strings.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
 
 using namespace muduo;
 
+const int TcpConnection::kZeroCopyLingerSeconds;
+
+namespace
+{
+
+typedef TcpConnection::ZeroCopyInFlight ZeroCopyInFlight;
+
+// 读出 fd 错误队列中的 MSG_ZEROCOPY 完成通知，释放已确认的内存持有者
+// 返回内核退回为拷贝的通知个数
+uint64_t reapZeroCopyCompletions(int fd, ZeroCopyInFlight* inFlight)
+{
+  uint64_t copied = 0;
+  for (;;) {
+    char control[128];
+    struct msghdr msg;
+    bzero(&msg, sizeof msg);
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof control;
+    if (::recvmsg(fd, &msg, MSG_ERRQUEUE) < 0) {
+      break;  // EAGAIN：队列已空
+    }
+    for (struct cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != NULL; cm = CMSG_NXTHDR(&msg, cm)) {
+      if (!((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR)
+            || (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))) {
+        continue;
+      }
+      const struct sock_extended_err* serr =
+          reinterpret_cast<const struct sock_extended_err*>(CMSG_DATA(cm));
+      if (serr->ee_errno != 0 || serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+        continue;
+      }
+      if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+        ++copied;
+      }
+      // [ee_info, ee_data] 内的发送都已完成，序号可能回绕，用差值比较
+      uint32_t hi = serr->ee_data;
+      while (!inFlight->empty()
+             && static_cast<int32_t>(inFlight->front().first - hi) <= 0) {
+        inFlight->pop_front();
+      }
+    }
+  }
+  return copied;
+}
+
+// 让 fd 关闭时发送 RST：内核直接丢弃发送队列，不会再读取其中零拷贝引用的内存
+void resetOnClose(int fd)
+{
+  struct linger lin;
+  lin.l_onoff = 1;
+  lin.l_linger = 0;
+  ::setsockopt(fd, SOL_SOCKET, SO_LINGER, &lin, sizeof lin);
+}
+
+// 连接关闭后仍在等待内核确认的零拷贝发送，fd 是 dup 出来的套接字，
+// 保证连接关闭后仍能读取错误队列
+struct ZeroCopyLinger
+{
+  ZeroCopyLinger(int sockfd, ZeroCopyInFlight&& pending, const std::string& connName)
+    : fd(sockfd), inFlight(std::move(pending)), name(connName),
+      deadline(std::chrono::steady_clock::now()
+               + std::chrono::seconds(TcpConnection::kZeroCopyLingerSeconds))
+  {
+  }
+
+  // 循环退出时定时器随之销毁，还没确认的也只能中止连接后释放
+  ~ZeroCopyLinger()
+  {
+    if (!inFlight.empty()) {
+      LOG << "TcpConnection [" << name << "] " << inFlight.size()
+          << " zero-copy sends unacknowledged, resetting connection";
+      resetOnClose(fd);
+    }
+    ::close(fd);
+  }
+
+  int fd;
+  ZeroCopyInFlight inFlight;
+  std::string name;
+  std::chrono::steady_clock::time_point deadline;
+};
+
+const double kZeroCopyLingerPollInterval = 0.01;
+
+void pollZeroCopyLinger(EventLoop* loop, const std::shared_ptr<ZeroCopyLinger>& linger)
+{
+  reapZeroCopyCompletions(linger->fd, &linger->inFlight);
+  if (!linger->inFlight.empty() && std::chrono::steady_clock::now() < linger->deadline) {
+    loop->runAfter(kZeroCopyLingerPollInterval, std::bind(&pollZeroCopyLinger, loop, linger));
+  }
+  // 否则最后一个引用随定时器回调一起释放，析构中关闭 fd
+}
+
+}
+
 TcpConnection::TcpConnection(EventLoop* loop,
                              const std::string& nameArg,
                              int sockfd,
                              const InetAddress& localAddr,
-                             const InetAddress& peerAddr)
+                             const InetAddress& peerAddr,
+                             uint64_t id)
+  : TcpConnection(loop, std::shared_ptr<const std::string>(), sockfd,
+                  localAddr, peerAddr, id)
+{
+  name_ = nameArg;
+}
+
+TcpConnection::TcpConnection(EventLoop* loop,
+                             const std::shared_ptr<const std::string>& namePrefix,
+                             int sockfd,
+                             const InetAddress& localAddr,
+                             const InetAddress& peerAddr,
+                             uint64_t id)
   : loop_(loop),  // 初始化事件循环
-    name_(nameArg),              // 设置连接名称
+    namePrefix_(namePrefix),     // 连接名称在 name() 中生成
+    id_(id),
     state_(kConnecting),         // 初始状态为连接中
     socket_(new Socket(sockfd)), // 创建 Socket 对象
     channel_(new Channel(loop, sockfd)), // 创建 Channel 对象
     localAddr_(localAddr),       // 本地地址
-    peerAddr_(peerAddr)          // 远程地址
+    peerAddr_(peerAddr),         // 远程地址
+    highWaterMark_(64 * 1024 * 1024),
+    lowWaterMark_(0),
+    aboveHighWaterMark_(false),
+    pauseReadingAboveHighWaterMark_(false),
+    readingPaused_(false),
+    inputBuffer_(loop->bufferPool()),
+    pendingOutputBytes_(0),
+    zeroCopyThreshold_(0),
+    zeroCopyNextId_(0),
+    zeroCopyCopied_(0),
+    ioBudget_(kDefaultIoBudget),  // 读写预算
+    queuedBytesReported_(0)
 {
-  LOG << "TcpConnection::ctor[" <<  name_ << "] at " << this
+  // 输入缓冲区一开始不占内存，读到数据时才从本循环的 BufferPool 借
+  LOG << "TcpConnection::ctor[id=" << id_ << "] at " << this
             << " fd=" << sockfd;
   channel_->setWReadCallback(
       std::bind(&TcpConnection::handleRead, this, std::placeholders::_1)); // 设置读回调函数
@@ -39,30 +178,226 @@ TcpConnection::TcpConnection(EventLoop* loop,
 
 TcpConnection::~TcpConnection()
 {
-  LOG << "TcpConnection::dtor[" <<  name_ << "] at " << this
+  LOG << "TcpConnection::dtor[id=" << id_ << "] at " << this
             << " fd=" << channel_->fd();
+  // 正常关闭时 connectDestroyed 已经把未确认的零拷贝发送交给循环等待；
+  // 这里仍有的话说明没有经过 connectDestroyed，只能先以 RST 关闭套接字再释放内存
+  if (!zeroCopyInFlight_.empty() && socket_) {
+    resetOnClose(socket_->fd());
+    socket_.reset();
+  }
+  for (size_t i = 0; i < pendingOutputs_.size(); ++i) {
+    if (pendingOutputs_[i].fd >= 0) {
+      ::close(pendingOutputs_[i].fd);
+    }
+  }
+}
+
+const std::string& TcpConnection::name() const
+{
+  if (namePrefix_) {
+    std::call_once(nameOnce_, [this] {
+      char buf[32];
+      snprintf(buf, sizeof buf, "#%" PRIu64, id_);
+      name_ = *namePrefix_ + buf;
+    });
+  }
+  return name_;
 }
 
 void TcpConnection::send(const std::string& message)
 {
   if (state_ == kConnected) {  // 如果连接已建立
     if (loop_->isInLoopThread()) {
-      sendInLoop(message);  // 直接在循环线程中发送
+      sendInLoop(message.data(), message.size());  // 直接在循环线程中发送
+    } else {
+      send(std::string(message));  // 只拷贝一次，之后移动
+    }
+  }
+}
+
+void TcpConnection::send(std::string&& message)
+{
+  if (state_ == kConnected) {
+    if (loop_->isInLoopThread()) {
+      sendInLoop(std::move(message));
     } else {
+      // 持有 shared_ptr，闭包执行时连接一定还活着
       loop_->runInLoop(
-          std::bind(&TcpConnection::sendInLoop, this, message)); // 调用 sendInLoop
+          [conn = shared_from_this(), msg = std::move(message)]() mutable
+          { conn->sendInLoop(std::move(msg)); });
     }
   }
 }
 
-void TcpConnection::sendInLoop(const std::string& message)
+void TcpConnection::send(const Slice* slices, size_t count)
 {
-  loop_->assertInLoopThread();  // 确保在循环线程中调用
+  if (state_ == kConnected) {
+    if (loop_->isInLoopThread()) {
+      sendInLoop(slices, count);
+    } else {
+      // 调用者的内存在投递之后就可能失效，只能拼接成一份拷贝
+      std::string message;
+      for (size_t i = 0; i < count; ++i) {
+        message.append(slices[i].data, slices[i].len);
+      }
+      send(std::move(message));
+    }
+  }
+}
+
+void TcpConnection::send(Buffer* buf)
+{
+  if (state_ == kConnected) {
+    if (loop_->isInLoopThread()) {
+      sendInLoop(buf->peek(), buf->readableBytes());
+      buf->retrieveAll();
+    } else {
+      send(buf->retrieveAsString());
+    }
+  }
+}
+
+void TcpConnection::sendFile(int fd, off_t offset, size_t length)
+{
+  if (state_ == kConnected && length > 0) {
+    int dupfd = ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (dupfd < 0) {
+      LOG << "TcpConnection::sendFile dup failed, errno=" << errno;
+      return;
+    }
+    if (loop_->isInLoopThread()) {
+      sendFileInLoop(dupfd, offset, length);
+    } else {
+      loop_->runInLoop(
+          [conn = shared_from_this(), dupfd, offset, length]
+          { conn->sendFileInLoop(dupfd, offset, length); });
+    }
+  }
+}
+
+void TcpConnection::sendFileInLoop(int fd, off_t offset, size_t length)
+{
+  loop_->assertInLoopThread();
+  if (state_ == kDisconnected) {
+    ::close(fd);
+    return;
+  }
+  if (pushPendingOutput(fd, std::shared_ptr<const void>(), NULL, offset, length, false)) {
+    handleWrite();  // 前面没有排队的数据，马上尝试发送
+  }
+}
+
+void TcpConnection::sendZeroCopy(const std::shared_ptr<const void>& owner,
+                                 const void* data, size_t len)
+{
+  if (state_ == kConnected) {
+    const char* p = static_cast<const char*>(data);
+    if (loop_->isInLoopThread()) {
+      sendZeroCopyInLoop(owner, p, len);
+    } else {
+      loop_->runInLoop([conn = shared_from_this(), owner, p, len]
+                       { conn->sendZeroCopyInLoop(owner, p, len); });
+    }
+  }
+}
+
+void TcpConnection::setZeroCopyThreshold(size_t bytes)
+{
+  if (bytes > 0 && !socket_->setZeroCopy(true)) {
+    LOG << "TcpConnection::setZeroCopyThreshold [" << name()
+        << "] SO_ZEROCOPY failed, errno=" << errno;
+    bytes = 0;
+  }
+  zeroCopyThreshold_ = bytes;
+}
+
+void TcpConnection::sendZeroCopyInLoop(const std::shared_ptr<const void>& owner,
+                                       const char* data, size_t len)
+{
+  loop_->assertInLoopThread();
+  if (state_ == kDisconnected) {
+    LOG << "TcpConnection::sendZeroCopyInLoop [" << name() << "] disconnected, give up writing";
+    return;
+  }
+  if (zeroCopyThreshold_ == 0 || len < zeroCopyThreshold_) {
+    sendInLoop(data, len);
+    return;
+  }
+  if (pushPendingOutput(-1, owner, data, 0, len, true)) {
+    handleWrite();
+  }
+}
+
+bool TcpConnection::pushPendingOutput(int fd, const std::shared_ptr<const void>& owner,
+                                      const char* data, off_t offset, size_t length,
+                                      bool zeroCopy)
+{
+  PendingOutput out;
+  out.fd = fd;
+  out.owner = owner;
+  out.data = data;
+  out.zeroCopy = zeroCopy;
+  out.after.setPool(loop_->chunkPool());
+  out.offset = offset;
+  out.remaining = length;
+  pendingOutputs_.push_back(std::move(out));
+  pendingOutputBytes_ += length;
+  updateQueuedBytes();
+  if (!channel_->isWriting()) {
+    channel_->enableWriting();
+    return true;
+  }
+  return false;
+}
+
+void TcpConnection::sendInLoop(const void* data, size_t len)
+{
+  Slice slice(data, len);
+  sendInLoop(&slice, 1);
+}
+
+void TcpConnection::sendInLoop(std::string&& message)
+{
+  loop_->assertInLoopThread();
+  if (state_ == kDisconnected) {
+    LOG << "TcpConnection::sendInLoop [" << name() << "] disconnected, give up writing";
+    return;
+  }
+  if (message.size() < kMinMovedTail) {
+    sendInLoop(message.data(), message.size());
+    return;
+  }
+  Slice slice(message);
+  size_t nwrote = writeDirect(&slice, 1, message.size());
+  if (nwrote < message.size()) {
+    if (message.size() - nwrote < kMinMovedTail) {
+      sendInLoop(message.data() + nwrote, message.size() - nwrote);
+    } else {
+      // 剩余部分原样排队，不拷贝
+      std::shared_ptr<std::string> owner = std::make_shared<std::string>(std::move(message));
+      pushPendingOutput(-1, owner, owner->data(), static_cast<off_t>(nwrote),
+                        owner->size() - nwrote, false);
+    }
+  }
+}
+
+size_t TcpConnection::writeDirect(const Slice* slices, size_t count, size_t total)
+{
+  // 一次 writev 最多带这么多段，其余的直接进输出缓冲区
+  const size_t kMaxIov = 64;
   ssize_t nwrote = 0;
-  if (!channel_->isWriting() && outputBuffer_.readableBytes() == 0) { // 如果没有在写
-    nwrote = ::write(channel_->fd(), message.data(), message.size()); // 直接写入
+  if (!channel_->isWriting() && outputQueueEmpty()) { // 如果没有在写
+    struct iovec vec[kMaxIov];
+    size_t iovcnt = std::min(count, kMaxIov);
+    for (size_t i = 0; i < iovcnt; ++i) {
+      vec[i].iov_base = const_cast<char*>(slices[i].data);
+      vec[i].iov_len = slices[i].len;
+    }
+    nwrote = iovcnt == 1 ? ::write(channel_->fd(), vec[0].iov_base, vec[0].iov_len)
+                         : ::writev(channel_->fd(), vec, static_cast<int>(iovcnt)); // 直接写入
     if (nwrote >= 0) {
-      if (static_cast<size_t>(nwrote) < message.size()) {
+      if (static_cast<size_t>(nwrote) < total) {
         LOG << "I am going to write more data";
       } else if (writeCompleteCallback_) {
         loop_->queueInLoop(
@@ -75,13 +410,43 @@ void TcpConnection::sendInLoop(const std::string& message)
       }
     }
   }
+  return static_cast<size_t>(nwrote);
+}
 
-  assert(nwrote >= 0);
-  if (static_cast<size_t>(nwrote) < message.size()) {  // 如果没写完，加入输出缓冲区
-    outputBuffer_.append(message.data() + nwrote, message.size() - nwrote);
+void TcpConnection::sendInLoop(const Slice* slices, size_t count)
+{
+  loop_->assertInLoopThread();  // 确保在循环线程中调用
+  // 跨线程投递的闭包持有连接，可能在 connectDestroyed 之后才执行，此时 fd 已经关闭
+  if (state_ == kDisconnected) {
+    LOG << "TcpConnection::sendInLoop [" << name() << "] disconnected, give up writing";
+    return;
+  }
+  size_t total = 0;
+  for (size_t i = 0; i < count; ++i) {
+    total += slices[i].len;
+  }
+  size_t nwrote = writeDirect(slices, count, total);
+  if (nwrote < total) {  // 如果没写完，剩余部分加入输出缓冲区
+    size_t skip = nwrote;
+    for (size_t i = 0; i < count; ++i) {
+      if (skip >= slices[i].len) {
+        skip -= slices[i].len;
+        continue;
+      }
+      size_t left = slices[i].len - skip;
+      if (pendingOutputs_.empty()) {
+        outputQueue_.append(slices[i].data + skip, left);
+      } else {
+        // 排在最后一个待发输出之后
+        pendingOutputs_.back().after.append(slices[i].data + skip, left);
+        pendingOutputBytes_ += left;
+      }
+      skip = 0;
+    }
     if (!channel_->isWriting()) {
       channel_->enableWriting();  // 启用写事件
     }
+    updateQueuedBytes();
   }
 }
 
@@ -89,7 +454,7 @@ void TcpConnection::shutdown()
 {
   if (state_ == kConnected) { // 如果已连接
     setState(kDisconnecting); // 设置状态为正在断开连接
-    loop_->runInLoop(std::bind(&TcpConnection::shutdownInLoop, this)); // 异步关闭连接
+    loop_->runInLoop(std::bind(&TcpConnection::shutdownInLoop, shared_from_this())); // 异步关闭连接
   }
 }
 
@@ -106,11 +471,25 @@ void TcpConnection::setTcpNoDelay(bool on)
   socket_->setTcpNoDelay(on);  // 设置 TCP_NODELAY 选项
 }
 
+void TcpConnection::setBusyPoll(int usec, bool prefer)
+{
+  if(!socket_->setBusyPoll(usec, prefer)) {
+    LOG<<"TcpConnection::setBusyPoll ["<<name()<<"] failed, errno="<<errno;
+  }
+}
+
+void TcpConnection::setEdgeTriggered(bool on)
+{
+  channel_->setEdgeTriggered(on);
+}
+
 void TcpConnection::connectEstablished()
 {
   loop_->assertInLoopThread();  // 确保在循环线程中调用
   assert(state_ == kConnecting);
   setState(kConnected);         // 设置状态为已连接
+  loop_->addConnections(1);     // 在 connectDestroyed 中减去，没有建立的连接不计数
+  outputQueue_.setPool(loop_->chunkPool());
   channel_->enableReading();    // 启用读事件
   connectionCallback_(shared_from_this()); // 调用连接回调函数
 }
@@ -124,46 +503,245 @@ void TcpConnection::connectDestroyed()
   connectionCallback_(shared_from_this()); // 调用连接回调
 
   loop_->removeChannel(channel_.get());    // 移除事件通道
+  lingerZeroCopy();
+  // 没发出去的数据丢弃，块在循环线程中还给 ChunkPool
+  inputBuffer_.retrieveAll();
+  inputBuffer_.releaseStorage();  // 把输入缓冲区的内存还给 BufferPool
+  outputQueue_.clear();
+  for (size_t i = 0; i < pendingOutputs_.size(); ++i) {
+    pendingOutputs_[i].after.clear();
+  }
+  loop_->addQueuedBytes(-queuedBytesReported_);
+  queuedBytesReported_ = 0;
+  loop_->addConnections(-1);
+}
+
+void TcpConnection::updateQueuedBytes()
+{
+  int64_t queued = static_cast<int64_t>(outputQueue_.readableBytes() + pendingOutputBytes_);
+  if (queued != queuedBytesReported_) {
+    loop_->addQueuedBytes(queued - queuedBytesReported_);
+    queuedBytesReported_ = queued;
+    checkWaterMarks(static_cast<size_t>(queued));
+  }
+}
+
+void TcpConnection::checkWaterMarks(size_t queued)
+{
+  if (!aboveHighWaterMark_ && queued >= highWaterMark_) {
+    aboveHighWaterMark_ = true;
+    if (highWaterMarkCallback_) {
+      loop_->queueInLoop(std::bind(highWaterMarkCallback_, shared_from_this(), queued));
+    }
+    if (pauseReadingAboveHighWaterMark_ && channel_->isReading()) {
+      channel_->disableReading();
+      readingPaused_ = true;
+    }
+  } else if (aboveHighWaterMark_ && queued <= lowWaterMark_) {
+    aboveHighWaterMark_ = false;
+    if (lowWaterMarkCallback_) {
+      loop_->queueInLoop(std::bind(lowWaterMarkCallback_, shared_from_this(), queued));
+    }
+    if (readingPaused_) {
+      readingPaused_ = false;
+      if (state_ == kConnected || state_ == kDisconnecting) {
+        channel_->enableReading();
+        if (channel_->isEdgeTriggered()) {
+          // 暂停期间到达的数据不会再有边沿通知，主动读一次
+          loop_->queueInLoop(std::bind(&TcpConnection::handleRead,
+                                       shared_from_this(), Timestamp::now()));
+        }
+      }
+    }
+  }
 }
 
 void TcpConnection::handleRead(Timestamp receiveTime)
 {
-  int savedErrno = 0;
-  ssize_t n = inputBuffer_.readfd(channel_->fd(), &savedErrno); // 从 fd 读取数据
-  if (n > 0) {
-    messageCallback_(shared_from_this(), &inputBuffer_, receiveTime); // 调用消息回调
-  } else if (n == 0) {
-    handleClose();  // 关闭连接
-  } else {
-    errno = savedErrno;
-    LOG << "TcpConnection::handleRead";
-    handleError();  // 处理错误
+  loop_->assertInLoopThread();
+  if (!channel_->isReading()) {  // 预算耗尽后补投的读取可能晚于连接关闭
+    return;
+  }
+  size_t budget = ioBudget_;
+  for (;;) {
+    int savedErrno = 0;
+    ssize_t n = inputBuffer_.readfd(channel_->fd(), &savedErrno); // 从 fd 读取数据
+    if (n > 0) {
+      messageCallback_(shared_from_this(), &inputBuffer_, receiveTime); // 调用消息回调
+      // 水平触发只读一次，剩余数据下次 poll 还会通知；越过高水位暂停读取时也停下
+      if (!channel_->isEdgeTriggered() || state_ == kDisconnected || !channel_->isReading()) {
+        break;
+      }
+      // 边缘触发下不会再通知，预算耗尽时投递到本轮循环末尾继续读
+      if (static_cast<size_t>(n) >= budget) {
+        loop_->queueInLoop(std::bind(&TcpConnection::handleRead,
+                                     shared_from_this(), receiveTime));
+        break;
+      }
+      budget -= n;
+    } else if (n == 0) {
+      handleClose();  // 关闭连接
+      break;
+    } else {
+      if (savedErrno != EAGAIN && savedErrno != EWOULDBLOCK) {
+        errno = savedErrno;
+        LOG << "TcpConnection::handleRead";
+        handleError();  // 处理错误
+      }
+      break;
+    }
+  }
+  // 读空了的冷连接把输入缓冲区的内存还给池，下次有数据时再借；
+  // 大流量连接保留内存，免得每次读到 EAGAIN 都借还一次
+  if (inputBuffer_.readableBytes() == 0 && inputBuffer_.readHint() < Buffer::kWarmReadSize) {
+    inputBuffer_.releaseStorage();
+  }
+}
+
+namespace
+{
+
+// sendfile 的错误是否出在文件(in_fd)上。只有 EINVAL、EIO、EOVERFLOW 可能来自文件，
+// 还要确认文件确实发不出去：不是 sendfile 支持的文件类型，或者在当前偏移处 pread 也失败。
+// 其余错误都是套接字的，交给 handleWrite 原来的出错路径
+bool isFileError(int fileFd, off_t offset, int err)
+{
+  if (err != EINVAL && err != EIO && err != EOVERFLOW) {
+    return false;
+  }
+  struct stat st;
+  if (::fstat(fileFd, &st) < 0 || (!S_ISREG(st.st_mode) && !S_ISBLK(st.st_mode))) {
+    return true;
+  }
+  if (err == EOVERFLOW) {
+    return true;  // 偏移加长度超出了文件能表示的范围
   }
+  char c;
+  return ::pread(fileFd, &c, 1, offset) < 0;
+}
+
+}
+
+ssize_t TcpConnection::writeQueued()
+{
+  if (!outputQueue_.empty()) {
+    // 一次 writev 最多带这么多块
+    const int kMaxIov = 64;
+    struct iovec vec[kMaxIov];
+    int iovcnt = outputQueue_.peek(vec, kMaxIov);
+    ssize_t n = iovcnt == 1 ? ::write(channel_->fd(), vec[0].iov_base, vec[0].iov_len)
+                            : ::writev(channel_->fd(), vec, iovcnt);
+    if (n > 0) {
+      outputQueue_.retrieve(n);  // 从队列中取出已写数据
+    }
+    return n;
+  }
+
+  assert(!pendingOutputs_.empty());
+  PendingOutput& out = pendingOutputs_.front();
+  ssize_t n = 0;
+  if (out.remaining > 0) {
+    if (out.fd >= 0) {
+      n = ::sendfile(channel_->fd(), out.fd, &out.offset, out.remaining);
+    } else if (!out.zeroCopy) {
+      n = ::write(channel_->fd(), out.data + out.offset, out.remaining);
+      if (n > 0) {
+        out.offset += n;
+      }
+    } else {
+      n = ::send(channel_->fd(), out.data + out.offset, out.remaining, MSG_ZEROCOPY);
+      if (n < 0 && errno == ENOBUFS) {
+        // 超过 optmem 限制，内核拒绝再锁定页，这一次退回普通发送
+        n = ::send(channel_->fd(), out.data + out.offset, out.remaining, 0);
+        if (n > 0) {
+          out.offset += n;
+        }
+      } else if (n >= 0) {
+        // 每次成功的调用都会产生一个通知序号，内存要保留到最后一个序号被确认
+        uint32_t id = zeroCopyNextId_++;
+        if (!zeroCopyInFlight_.empty() && zeroCopyInFlight_.back().second == out.owner) {
+          zeroCopyInFlight_.back().first = id;
+        } else {
+          zeroCopyInFlight_.emplace_back(id, out.owner);
+        }
+        out.offset += n;
+      }
+    }
+    if (n < 0) {
+      int savedErrno = errno;
+      if (out.fd < 0 || !isFileError(out.fd, out.offset, savedErrno)) {
+        errno = savedErrno;
+        return n;
+      }
+      // 文件本身读不出来，套接字没有问题也就不会有关闭事件，
+      // 留在队首会让写事件一直触发，只能像文件被截断一样丢掉剩下的部分
+      LOG << "TcpConnection::writeQueued sendfile failed, errno=" << savedErrno
+          << ", dropping " << out.remaining << " bytes";
+      n = 0;
+    } else if (n == 0) {
+      LOG << "TcpConnection::writeQueued file truncated, dropping "
+          << out.remaining << " bytes";
+    }
+    if (n == 0) {
+      // 文件比声明的短或者读取出错，剩下的无法发送
+      pendingOutputBytes_ -= out.remaining;
+      out.remaining = 0;
+    } else {
+      out.remaining -= n;
+      pendingOutputBytes_ -= n;
+    }
+  }
+  if (out.remaining == 0) {
+    // 发完，排在它后面的数据接着发
+    if (out.fd >= 0) {
+      ::close(out.fd);
+    }
+    pendingOutputBytes_ -= out.after.readableBytes();
+    outputQueue_.splice(&out.after);
+    pendingOutputs_.pop_front();
+  }
+  return n;
 }
 
 void TcpConnection::handleWrite()
 {
   loop_->assertInLoopThread();  // 确保在循环线程中调用
   if (channel_->isWriting()) {  // 如果正在写入
-    ssize_t n = ::write(channel_->fd(),
-                        outputBuffer_.peek(),
-                        outputBuffer_.readableBytes());
-    if (n > 0) {
-      outputBuffer_.retrieve(n);  // 从缓冲区中取出已写数据
-      if (outputBuffer_.readableBytes() == 0) {
-        channel_->disableWriting();  // 禁用写事件
-        if (writeCompleteCallback_) {
-          loop_->queueInLoop(
-              std::bind(writeCompleteCallback_, shared_from_this())); // 写完成回调
+    size_t budget = ioBudget_;
+    for (;;) {
+      ssize_t n = writeQueued();
+      if (n >= 0) {
+        updateQueuedBytes();
+        if (outputQueueEmpty()) {
+          channel_->disableWriting();  // 禁用写事件
+          if (writeCompleteCallback_) {
+            loop_->queueInLoop(
+                std::bind(writeCompleteCallback_, shared_from_this())); // 写完成回调
+          }
+          if (state_ == kDisconnecting) {
+            shutdownInLoop();  // 如果正在断开连接，则关闭连接
+          }
+          break;
         }
-        if (state_ == kDisconnecting) {
-          shutdownInLoop();  // 如果正在断开连接，则关闭连接
+        if (n == 0) {
+          continue;
         }
+        if (!channel_->isEdgeTriggered()) {
+          LOG << "I am going to write more data";
+          break;
+        }
+        if (static_cast<size_t>(n) >= budget) {
+          loop_->queueInLoop(std::bind(&TcpConnection::handleWrite,
+                                       shared_from_this()));
+          break;
+        }
+        budget -= n;
       } else {
-        LOG << "I am going to write more data";
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+          LOG << "TcpConnection::handleWrite";
+        }
+        break;
       }
-    } else {
-      LOG << "TcpConnection::handleWrite";
     }
   } else {
     LOG << "Connection is down, no more writing";
@@ -179,9 +757,42 @@ void TcpConnection::handleClose()
   closeCallback_(shared_from_this()); // 调用关闭回调
 }
 
+void TcpConnection::readZeroCopyCompletions()
+{
+  zeroCopyCopied_ += reapZeroCopyCompletions(channel_->fd(), &zeroCopyInFlight_);
+}
+
+void TcpConnection::lingerZeroCopy()
+{
+  readZeroCopyCompletions();
+  if (zeroCopyInFlight_.empty()) {
+    return;
+  }
+  int fd = ::dup(channel_->fd());
+  if (fd < 0) {
+    // 无法继续等待，中止连接，内核丢弃发送队列后才释放内存
+    LOG << "TcpConnection::lingerZeroCopy [" << name() << "] dup failed, errno=" << errno;
+    resetOnClose(channel_->fd());
+    socket_.reset();
+    zeroCopyInFlight_.clear();
+    return;
+  }
+  std::shared_ptr<ZeroCopyLinger> linger =
+      std::make_shared<ZeroCopyLinger>(fd, std::move(zeroCopyInFlight_), name());
+  zeroCopyInFlight_.clear();
+  pollZeroCopyLinger(loop_, linger);
+}
+
 void TcpConnection::handleError()
 {
+  if (!zeroCopyInFlight_.empty()) {
+    // 零拷贝完成通知通过错误队列送达，也会触发 POLLERR
+    readZeroCopyCompletions();
+  }
   int err = sockets::getSocketError(channel_->fd());
-  LOG << "TcpConnection::handleError [" << name_
+  if (err == 0) {
+    return;
+  }
+  LOG << "TcpConnection::handleError [" << name()
             << "] - SO_ERROR = " << err << " " << strerror(err); // 输出错误日志
 }
\ No newline at end of file
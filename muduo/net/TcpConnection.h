@@ -3,14 +3,19 @@
 #ifndef TCPCONNECTION_H
 #define TCPCONNECTION_H
 
+#include <deque>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 
+#include <sys/types.h>
+
 
 #include "../Callbacks.h"
 #include "Buffer.h"
 #include "InetAddress.h"
+#include "OutputQueue.h"
 #include "TimeStamp.h"
 
 namespace muduo
@@ -20,6 +25,16 @@ class Channel;
 class EventLoop;
 class Socket;
 
+/// send() 的一段数据，只描述内存，不拥有它
+struct Slice
+{
+  Slice(const void* d, size_t n) : data(static_cast<const char*>(d)), len(n) {}
+  Slice(const std::string& s) : data(s.data()), len(s.size()) {}
+
+  const char* data;
+  size_t len;
+};
+
 ///
 /// TCP 连接类，适用于客户端和服务器端
 ///
@@ -33,20 +48,61 @@ class TcpConnection : public std::enable_shared_from_this<TcpConnection>
                 const std::string& name,
                 int sockfd,
                 const InetAddress& localAddr,
-                const InetAddress& peerAddr);
+                const InetAddress& peerAddr,
+                uint64_t id = 0);
+  /// TcpServer 用：名称在第一次调用 name() 时才由 namePrefix 和 id 拼出，
+  /// 接受连接时不构造字符串；namePrefix 由同一个服务器的所有连接共享
+  TcpConnection(EventLoop* loop,
+                const std::shared_ptr<const std::string>& namePrefix,
+                int sockfd,
+                const InetAddress& localAddr,
+                const InetAddress& peerAddr,
+                uint64_t id);
   ~TcpConnection();
 
   EventLoop* getLoop() const { return loop_; }   // 获取事件循环对象指针
-  const std::string& name() const { return name_; }  // 获取连接名称
+  const std::string& name() const;  // 获取连接名称
+  uint64_t id() const { return id_; }  // TcpServer 连接表中的 id，TcpClient 的连接为 0
   const InetAddress& localAddress() { return localAddr_; }  // 获取本地地址
   const InetAddress& peerAddress() { return peerAddr_; }    // 获取远程地址
   bool connected() const { return state_ == kConnected; }   // 判断是否已连接
 
   // 线程安全地发送数据
   void send(const std::string& message);
+  // message 被移动到循环线程中，没写完的部分较大时直接排队发送，不再拷进输出缓冲区
+  void send(std::string&& message);
+  // 把多段数据按顺序发送，在循环线程中用一次 writev，只有没写完的部分才拷进输出缓冲区
+  // 在其他线程调用时会先把各段拼接成一份拷贝
+  void send(const Slice* slices, size_t count);
+  // 发送 buf 中的全部可读数据并清空 buf
+  void send(Buffer* buf);
+  // 用 sendfile(2) 发送文件 fd 从 offset 开始的 length 字节，与前后的 send 按调用顺序发出
+  // 连接内部会 dup 一份 fd，调用者可以立即关闭自己的 fd
+  void sendFile(int fd, off_t offset, size_t length);
+  // 不小于零拷贝阈值时用 send(MSG_ZEROCOPY) 直接从 data 发送，不拷贝到输出缓冲区；
+  // owner 持有 data 所在的内存，直到内核在错误队列中确认发送完成才释放；
+  // 连接关闭时还没确认的 owner 交给循环继续等待，最多 kZeroCopyLingerSeconds 秒，
+  // 超时后以 RST 中止连接(丢弃未发出的数据)再释放
+  // 小于阈值或未开启零拷贝时与 send(data, len) 相同
+  void sendZeroCopy(const std::shared_ptr<const void>& owner, const void* data, size_t len);
+  static const int kZeroCopyLingerSeconds = 30;
+  // 已发出但内核尚未确认的零拷贝发送：(最后一次 send 的序号, 内存持有者)
+  typedef std::deque<std::pair<uint32_t, std::shared_ptr<const void>>> ZeroCopyInFlight;
+  // 开启 SO_ZEROCOPY 并设置阈值，0 表示关闭；页映射有固定开销，一般只对几十KB以上的数据划算
+  void setZeroCopyThreshold(size_t bytes);
+  // 零拷贝发送中内核退回为拷贝的次数(例如发往本机回环)
+  uint64_t zeroCopyCopied() const { return zeroCopyCopied_; }
   // 线程安全地关闭连接
   void shutdown();
   void setTcpNoDelay(bool on);  // 设置 TCP_NO_DELAY 选项
+  void setBusyPoll(int usec, bool prefer);  // 设置 SO_BUSY_POLL 选项
+
+  // 边缘触发模式：可读/可写时循环读写直到 EAGAIN
+  // 应在 connectEstablished 之前或在循环线程中调用
+  void setEdgeTriggered(bool on);
+  // 每次唤醒最多读/写的字节数，用完后让出事件循环，避免一个连接饿死其他连接
+  void setIoBudget(size_t bytes) { ioBudget_ = bytes; }
+  size_t ioBudget() const { return ioBudget_; }
 
   void setConnectionCallback(const ConnectionCallback& cb)
   { connectionCallback_ = cb; } // 设置连接回调
@@ -57,6 +113,16 @@ class TcpConnection : public std::enable_shared_from_this<TcpConnection>
   void setWriteCompleteCallback(const WriteCompleteCallback& cb)
   { writeCompleteCallback_ = cb; }  // 设置写完成回调
 
+  // 待发送字节数(输出缓冲区加上排队的文件/内存)涨到 highWaterMark 时调用一次，
+  // 之后降到低水位以下才会再次触发
+  void setHighWaterMarkCallback(const HighWaterMarkCallback& cb, size_t highWaterMark)
+  { highWaterMarkCallback_ = cb; highWaterMark_ = highWaterMark; }
+  // 越过高水位之后待发送字节数降到 lowWaterMark 及以下时调用，用来恢复生产
+  void setLowWaterMarkCallback(const LowWaterMarkCallback& cb, size_t lowWaterMark)
+  { lowWaterMarkCallback_ = cb; lowWaterMark_ = lowWaterMark; }
+  // 越过高水位时自动停止读取对端数据，回到低水位再恢复，把背压传给对端
+  void setPauseReadingAboveHighWaterMark(bool on) { pauseReadingAboveHighWaterMark_ = on; }
+
   /// 仅供内部使用
   void setCloseCallback(const CloseCallback& cb)
   { closeCallback_ = cb; }  // 设置关闭回调
@@ -68,17 +134,39 @@ class TcpConnection : public std::enable_shared_from_this<TcpConnection>
 
  private:
   enum StateE { kConnecting, kConnected, kDisconnecting, kDisconnected, }; // 定义状态
+  static const size_t kDefaultIoBudget = 1024 * 1024; // 默认每次唤醒的读写预算
+  static const size_t kMinMovedTail = 8 * 1024; // 移入的 string 剩余至少这么多时才原样排队，否则拷贝
 
   void setState(StateE s) { state_ = s; } // 设置状态
   void handleRead(Timestamp receiveTime);  // 处理读事件
   void handleWrite();  // 处理写事件
   void handleClose();  // 处理关闭事件
   void handleError();  // 处理错误事件
-  void sendInLoop(const std::string& message);  // 在循环中发送
+  void sendInLoop(const void* data, size_t len);  // 在循环中发送
+  void sendInLoop(const Slice* slices, size_t count);
+  void sendInLoop(std::string&& message);
+  // 输出队列为空时直接写，返回写出的字节数(出错返回 0)
+  size_t writeDirect(const Slice* slices, size_t count, size_t total);
+  void sendFileInLoop(int fd, off_t offset, size_t length);
+  void sendZeroCopyInLoop(const std::shared_ptr<const void>& owner, const char* data, size_t len);
+  // 排到输出队列末尾，调用前输出队列为空时返回 true，调用者可以立即 handleWrite()
+  bool pushPendingOutput(int fd, const std::shared_ptr<const void>& owner,
+                         const char* data, off_t offset, size_t length, bool zeroCopy);
+  void readZeroCopyCompletions();  // 读取错误队列中的 MSG_ZEROCOPY 完成通知
+  void lingerZeroCopy();           // 关闭时把未确认的零拷贝内存交给循环继续等待
+  // 写出输出队列最前面的数据：>0 为写出的字节数，0 表示丢弃了一个读不出数据的文件，<0 出错
+  ssize_t writeQueued();
+  bool outputQueueEmpty() const
+  { return outputQueue_.empty() && pendingOutputs_.empty(); }
   void shutdownInLoop();  // 在循环中关闭连接
+  void updateQueuedBytes();  // 把输出缓冲区大小的变化计入 loop_->queuedBytes()，并检查水位
+  void checkWaterMarks(size_t queued);
 
   EventLoop* loop_;        // 事件循环
-  std::string name_;       // 连接名称
+  std::shared_ptr<const std::string> namePrefix_;  // 非空时 name_ 按需生成
+  mutable std::string name_;       // 连接名称
+  mutable std::once_flag nameOnce_;
+  const uint64_t id_;      // 连接 id
   StateE state_;           // 连接状态，使用原子变量改进
   std::unique_ptr<Socket> socket_;   // Socket 对象
   std::unique_ptr<Channel> channel_; // Channel 对象
@@ -87,9 +175,38 @@ class TcpConnection : public std::enable_shared_from_this<TcpConnection>
   ConnectionCallback connectionCallback_;  // 连接回调
   MessageCallback messageCallback_;        // 消息回调
   WriteCompleteCallback writeCompleteCallback_;  // 写完成回调
+  HighWaterMarkCallback highWaterMarkCallback_;  // 高水位回调
+  LowWaterMarkCallback lowWaterMarkCallback_;    // 低水位回调
+  size_t highWaterMark_;
+  size_t lowWaterMark_;
+  bool aboveHighWaterMark_;
+  bool pauseReadingAboveHighWaterMark_;
+  bool readingPaused_;     // 因为越过高水位而停止了读取
   CloseCallback closeCallback_;            // 关闭回调
-  Buffer inputBuffer_;    // 输入缓冲区
-  Buffer outputBuffer_;   // 输出缓冲区
+  Buffer inputBuffer_;    // 输入缓冲区，由所在循环的 BufferPool 提供内存，读空即归还
+  OutputQueue outputQueue_;  // 输出队列，由所在循环的 ChunkPool 提供内存
+
+  // 不经过 outputQueue_ 发送的数据：sendfile 的文件或零拷贝发送的内存，
+  // outputQueue_ 写完后才轮到第一个；其后 send 的数据放在 after 中，发完后接到 outputQueue_
+  struct PendingOutput
+  {
+    int fd;            // 文件：dup 得到的，发完后关闭；内存为 -1
+    std::shared_ptr<const void> owner;  // 内存：data 的持有者
+    const char* data;
+    bool zeroCopy;     // 内存：是否用 MSG_ZEROCOPY 发送
+    off_t offset;      // 文件偏移，或已发出的内存字节数
+    size_t remaining;
+    OutputQueue after;
+  };
+  std::deque<PendingOutput> pendingOutputs_;
+  size_t pendingOutputBytes_;  // pendingOutputs_ 中剩余字节与 after 字节之和
+
+  size_t zeroCopyThreshold_;   // 0 表示不使用 MSG_ZEROCOPY
+  uint32_t zeroCopyNextId_;    // 下一次零拷贝 send 的通知序号，内核从 0 开始按次递增
+  ZeroCopyInFlight zeroCopyInFlight_;  // 已发出但内核尚未确认的零拷贝发送
+  uint64_t zeroCopyCopied_;
+  size_t ioBudget_;       // 每次唤醒的读写预算
+  int64_t queuedBytesReported_;  // 已计入 loop_->queuedBytes() 的字节数
 };
 
 typedef std::shared_ptr<TcpConnection> TcpConnectionPtr; // 使用标准库智能指针
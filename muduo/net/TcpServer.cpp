@@ -9,25 +9,94 @@
 #include "SocketsOps.h"
 #include "Acceptor.h"
 #include "TcpConnection.h"
+#include "thread/Condition.h"
 
 using namespace muduo;
 
+namespace
+{
+
+// mutex 为空时不加锁
+class OptionalLockGuard
+{
+public:
+  explicit OptionalLockGuard(MutexLock* mutex) : mutex_(mutex)
+  {
+    if(mutex_) {
+      mutex_->lock();
+    }
+  }
+  ~OptionalLockGuard()
+  {
+    if(mutex_) {
+      mutex_->unlock();
+    }
+  }
+
+  OptionalLockGuard(const OptionalLockGuard&) = delete;
+  OptionalLockGuard& operator=(const OptionalLockGuard&) = delete;
+
+private:
+  MutexLock* mutex_;
+};
+
+}
+
 //构造函数初始化
-TcpServer::TcpServer(EventLoop* loop,const InetAddress& listenAddr)
+TcpServer::TcpServer(EventLoop* loop,const InetAddress& listenAddr,Option option,
+                     const ListenOptions& listenOptions)
   : loop_(loop),
     name_(listenAddr.toHostPort()),
-    acceptor_(new Acceptor(loop,listenAddr)),
+    connNamePrefix_(std::make_shared<const std::string>(name_)),
+    listenAddr_(listenAddr),
+    reusePort_(option == kReusePort),
+    listenOptions_(listenOptions),
+    acceptor_(reusePort_ ? nullptr : newAcceptor(loop)),
     started_(false),
-    nextConnId_(1)
+    edgeTriggered_(false),
+    busyPollUs_(0),
+    preferBusyPoll_(false),
+    threadPool_(new EventLoopThreadPool(loop))
 {
-  // 设置新的连接回调函数，当有新连接时调用 newConnection 方法
-  acceptor_->setNewConnectionCallback(
-      [this](auto && PH1, auto && PH2) { newConnection(std::forward<decltype(PH1)>(PH1), std::forward<decltype(PH2)>(PH2)); });
-
 }
 
 //析构函数
-TcpServer::~TcpServer() = default;
+TcpServer::~TcpServer()
+{
+  // kReusePort 时各 Acceptor 的 Channel 注册在IO循环上，要在那个循环里注销，
+  // 而且要赶在 threadPool_ 析构、IO循环退出之前，所以在这里同步地逐个销毁
+  if(loopAcceptors_.empty()) {
+    return;
+  }
+  MutexLock mutex;
+  Condition cond(mutex);
+  size_t remaining = loopAcceptors_.size();
+  for(std::unique_ptr<Acceptor>& acceptor : loopAcceptors_) {
+    EventLoop* ioLoop = acceptor->getLoop();
+    ioLoop->runInLoop([acceptor = std::move(acceptor), &mutex, &cond, &remaining]() mutable {
+      acceptor.reset();
+      MutexLockGuard lock(mutex);
+      if(--remaining == 0) {
+        cond.notify();
+      }
+    });
+  }
+  MutexLockGuard lock(mutex);
+  while(remaining > 0) {
+    cond.wait();
+  }
+  loopAcceptors_.clear();
+}
+
+std::unique_ptr<Acceptor> TcpServer::newAcceptor(EventLoop* acceptLoop)
+{
+  std::unique_ptr<Acceptor> acceptor(new Acceptor(acceptLoop,listenAddr_,reusePort_));
+  acceptor->setListenOptions(listenOptions_);
+  // 设置新的连接回调函数，当有新连接时调用 newConnection 方法
+  acceptor->setNewConnectionCallback(
+      [this,acceptLoop](int sockfd,const InetAddress& peerAddr) { newConnection(acceptLoop,sockfd,peerAddr); });
+  return acceptor;
+}
 
 
 void TcpServer::setThreadNum(int numThreads)
@@ -42,41 +111,64 @@ void TcpServer::start() {
   //如果服务器还未启动，则将其标记为启动
   if(!started_) {
     started_ = true;
+    threadPool_->start(threadInitCallback_);
+
+    if(reusePort_) {
+      for(EventLoop* ioLoop : threadPool_->getAllLoops()) {
+        if(ioLoop == loop_) {
+          continue;
+        }
+        std::unique_ptr<Acceptor> acceptor(newAcceptor(ioLoop));
+        ioLoop->runInLoop([capture0 = acceptor.get()] { capture0->listen(); });
+        loopAcceptors_.push_back(std::move(acceptor));
+      }
+      //没有IO线程时由 base loop 监听
+      if(loopAcceptors_.empty()) {
+        acceptor_ = newAcceptor(loop_);
+      }
+    }
   }
 
   //如果acceptor 尚未开始监听，则在事件循环中调用listen方法
-  if(!acceptor_->listening()) {
+  if(acceptor_ && !acceptor_->listening()) {
     loop_->runInLoop([capture0 = acceptor_.get()] { capture0->listen(); });
   }
 }
 
 //当有新连接与来时调用的函数
-void TcpServer::newConnection(int sockfd, const InetAddress& peerAddr){
+void TcpServer::newConnection(EventLoop* acceptLoop, int sockfd, const InetAddress& peerAddr){
   //确保是在IO线程执行
-  loop_->assertInLoopThread();
+  acceptLoop->assertInLoopThread();
 
-  char buf[32];
-  snprintf(buf,sizeof buf,"#%d",nextConnId_);
-  ++nextConnId_;
+  ConnectionTable::Id connId;
+  {
+    OptionalLockGuard lock(connectionsMutex());
+    connId = connections_.allocate();
+  }
 
-  //生成新连接的名称
-  std::string connName = name_+buf;
+  //连接名称(name_#id)只在用到时才生成，这里不构造字符串
   LOG<<"TcpServer::new Connection ["<<name_
-  <<"] -新的连接 ["<<connName<<"] 来自"<<peerAddr.toHostPort();
+  <<"] -新的连接 [#"<<connId<<"] 来自"<<peerAddr.toHostPort();
 
 
   //获取本地地址
   InetAddress localAddr(sockets::getLocalAddr(sockfd));
 
-  EventLoop* ioLoop = threadPool_->getNextLoop();
+  // 只用IP不用端口，同一客户端的多个连接落到同一个循环
+  EventLoop* ioLoop = acceptLoop == loop_
+                     ? threadPool_->getLoop(peerAddr.getSockAddrInet().sin_addr.s_addr)
+                     : acceptLoop;
 
 
   //创建新的TcpConnection对象
-  TcpConnectionPtr conn(std::make_shared<TcpConnection>(ioLoop,connName, sockfd,
-                                                        localAddr, peerAddr));
+  TcpConnectionPtr conn(std::make_shared<TcpConnection>(ioLoop,connNamePrefix_, sockfd,
+                                                        localAddr, peerAddr, connId));
 
   // 保存连接map
-  connections_[connName] = conn;
+  {
+    OptionalLockGuard lock(connectionsMutex());
+    connections_.set(connId,conn);
+  }
 
   //设置好连接回调函数和消息回调函数
   conn->setConnectionCallback(connectionCallback_);
@@ -84,6 +176,10 @@ void TcpServer::newConnection(int sockfd, const InetAddress& peerAddr){
   conn->setWriteCompleteCallback(writeCompleteCallback_);
   conn->setCloseCallback(
     std::bind(&TcpServer::removeConnection, this, std::placeholders::_1));
+  conn->setEdgeTriggered(edgeTriggered_);
+  if(busyPollUs_ > 0) {
+    conn->setBusyPoll(busyPollUs_, preferBusyPoll_);
+  }
 
   //通知连接已经建立
   ioLoop->runInLoop(std::bind(&TcpConnection::connectEstablished, conn));
@@ -91,16 +187,25 @@ void TcpServer::newConnection(int sockfd, const InetAddress& peerAddr){
 }
 
 void TcpServer::removeConnection(const TcpConnectionPtr& conn){
-  loop_->runInLoop(std::bind(&TcpServer::removeConnectionInLoop,this,conn));
+  if(loopAcceptors_.empty()) {
+    loop_->runInLoop(std::bind(&TcpServer::removeConnectionInLoop,this,conn));
+  }else {
+    //连接由所在的IO循环接受，也在那里移除
+    removeConnectionInLoop(conn);
+  }
 }
 
 void TcpServer::removeConnectionInLoop(const TcpConnectionPtr& conn) {
-  loop_->assertInLoopThread();
   LOG<<"TcpServer::removeConnectionInLoop ["<<name_<<"] - connection"<<conn->name();
-  size_t n = connections_.erase(conn->name());
-  assert(n == 1);
+  bool erased;
+  {
+    OptionalLockGuard lock(connectionsMutex());
+    erased = connections_.erase(conn->id());
+  }
+  assert(erased);
+  (void)erased;
   EventLoop* ioLoop = conn->getLoop();
-  ioLoop->runInLoop(std::bind(&TcpConnection::connectDestroyed,conn));;
+  ioLoop->queueInLoop(std::bind(&TcpConnection::connectDestroyed,conn));
 }
 
 
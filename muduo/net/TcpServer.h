@@ -3,12 +3,15 @@
 #ifndef TCPSERVER_H
 #define TCPSERVER_H
 
-#include <map>
+#include <vector>
 
 #include "../EventLoopThreadPool.h"
 #include "../Callbacks.h"
 #include "../EventLoop.h"
+#include "ConnectionTable.h"
 #include "InetAddress.h"
+#include "ListenOptions.h"
+#include "../thread/Mutex.h"
 
 namespace muduo {
 class Acceptor;
@@ -16,10 +19,22 @@ class Eventloop;
 
 class TcpServer {
 public:
-  TcpServer(EventLoop* loop,const InetAddress& listenAddr);
+  enum Option {
+    kNoReusePort,
+    // 每个IO循环各有一个设置了 SO_REUSEPORT 的 Acceptor，由内核分配新连接，
+    // 连接在接受它的循环上建立，不需要跨线程转交；没有IO线程时等同于 kNoReusePort
+    kReusePort,
+  };
+
+  TcpServer(EventLoop* loop,const InetAddress& listenAddr,Option option = kNoReusePort,
+            const ListenOptions& listenOptions = ListenOptions());
   ~TcpServer();
 
   void setThreadNum(int numThreads);
+  // 用于设置IO线程绑核等，须在 start() 之前调用
+  EventLoopThreadPool* threadPool() { return threadPool_.get(); }
+  // 新连接的分配策略，kConsistentHash 按对端IP哈希，须在 start() 之前设置
+  void setLoadBalance(EventLoopThreadPool::LoadBalance lb) { threadPool_->setLoadBalance(lb); }
 
   void start();
 
@@ -30,24 +45,52 @@ public:
   void setWriteCompleteCallback(const WriteCompleteCallback& cb)
   { writeCompleteCallback_ = cb; }
 
+  // 新连接使用边缘触发模式(仅epoll后端生效)，须在 start() 之前设置
+  void setEdgeTriggered(bool on) { edgeTriggered_ = on; }
+
+  // 在每个IO线程的循环开始前调用，例如 loop->setBusyPollUs(50)，须在 start() 之前设置
+  void setThreadInitCallback(const EventLoopThreadPool::ThreadInitCallback& cb)
+  { threadInitCallback_ = cb; }
+
+  // 新连接设置 SO_BUSY_POLL，usec 为 0 表示不设置
+  void setSocketBusyPoll(int usec, bool prefer = false)
+  { busyPollUs_ = usec; preferBusyPoll_ = prefer; }
+
 private:
 
-  void newConnection(int sockfd,const InetAddress& peerAddr);
+  // 在 acceptLoop 上监听的 Acceptor，新连接交给 newConnection
+  std::unique_ptr<Acceptor> newAcceptor(EventLoop* acceptLoop);
+  // 在 acceptLoop 中调用；kReusePort 时连接就建立在 acceptLoop 上
+  void newConnection(EventLoop* acceptLoop,int sockfd,const InetAddress& peerAddr);
   void removeConnection(const TcpConnectionPtr& conn);
 
   void removeConnectionInLoop(const TcpConnectionPtr& conn);
 
-  typedef std::map<std::string,TcpConnectionPtr> ConnectionMap;
+  // 只有 base loop 接受连接时连接表只在 loop_ 中增删，不需要锁，返回 nullptr
+  MutexLock* connectionsMutex() { return loopAcceptors_.empty() ? nullptr : &mutex_; }
 
   EventLoop* loop_;
   const std::string name_;
+  // 连接名称的前缀，所有连接共享，连接名称在用到时才拼上 id
+  const std::shared_ptr<const std::string> connNamePrefix_;
+  const InetAddress listenAddr_;
+  const bool reusePort_;
+  const ListenOptions listenOptions_;
+  // base loop 上的 Acceptor；kReusePort 且有IO线程时不创建
   std::shared_ptr<Acceptor> acceptor_{};
+  // kReusePort 时每个IO循环上的 Acceptor，析构函数中在各自的循环里销毁
+  std::vector<std::unique_ptr<Acceptor>> loopAcceptors_;
   ConnectionCallback connectionCallback_{};
   MessageCallback messageCallback_{};
   WriteCompleteCallback writeCompleteCallback_;
   bool started_;
-  int nextConnId_;
-  ConnectionMap connections_{};
+  bool edgeTriggered_;
+  int busyPollUs_;
+  bool preferBusyPoll_;
+  EventLoopThreadPool::ThreadInitCallback threadInitCallback_;
+  // kReusePort 时连接在各IO线程中增删，由它保护
+  MutexLock mutex_;
+  ConnectionTable connections_;
   std::unique_ptr<EventLoopThreadPool> threadPool_;
 
 
@@ -0,0 +1,152 @@
+// MpscQueue 与原先 MutexLock + std::vector 交换方案的对比，
+// 以及用 Task 代替 std::function 之后的效果
+// 用法: test14 [producers] [itemsPerProducer]
+
+#include "Task.h"
+#include "thread/MpscQueue.h"
+#include "thread/Mutex.h"
+#include "thread/Thread.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <vector>
+
+typedef std::function<void()> Functor;
+
+// EventLoop 原来的 pendingFunctors_ 实现
+class MutexVectorQueue
+{
+public:
+  void push(const Functor& cb)
+  {
+    muduo::MutexLockGuard lock(mutex_);
+    pending_.push_back(cb);
+  }
+
+  size_t drain()
+  {
+    std::vector<Functor> functors;
+    {
+      muduo::MutexLockGuard lock(mutex_);
+      functors.swap(pending_);
+    }
+    for (size_t i = 0; i < functors.size(); ++i)
+    {
+      functors[i]();
+    }
+    return functors.size();
+  }
+
+private:
+  muduo::MutexLock mutex_;
+  std::vector<Functor> pending_;
+};
+
+class MpscFunctorQueue
+{
+public:
+  void push(const Functor& cb)
+  {
+    queue_.push(cb);
+  }
+
+  size_t drain()
+  {
+    return queue_.consume([](Functor& f) { f(); }, 1024);
+  }
+
+private:
+  muduo::MpscQueue<Functor> queue_;
+};
+
+// EventLoop 现在的实现
+class MpscTaskQueue
+{
+public:
+  template<typename F>
+  void push(F&& cb)
+  {
+    queue_.push(muduo::Task(std::forward<F>(cb)));
+  }
+
+  size_t drain()
+  {
+    return queue_.consume([](muduo::Task& f) { f(); }, 1024);
+  }
+
+private:
+  muduo::MpscQueue<muduo::Task> queue_;
+};
+
+int64_t g_sum = 0;
+
+template<typename Queue>
+double bench(const char* name, int producers, int itemsPerProducer, bool withPayload)
+{
+  Queue queue;
+  std::atomic<int> done(0);
+  g_sum = 0;
+  std::vector<std::unique_ptr<muduo::Thread>> threads;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < producers; ++i)
+  {
+    threads.emplace_back(new muduo::Thread([&queue, &done, itemsPerProducer, withPayload] {
+      // 模拟 sendInLoop 的闭包：一个指针加一份 std::string；
+      // 不带 payload 时只有一个指针，测的主要是队列本身的开销
+      std::string payload(64, 'x');
+      for (int j = 0; j < itemsPerProducer; ++j)
+      {
+        if (withPayload)
+        {
+          queue.push([p = &done, payload] { (void)p; g_sum += payload.size() > 0; });
+        }
+        else
+        {
+          queue.push([p = &done] { (void)p; ++g_sum; });
+        }
+      }
+      ++done;
+    }));
+    threads.back()->start();
+  }
+
+  // 当前线程扮演 EventLoop，单消费者
+  int64_t total = static_cast<int64_t>(producers) * itemsPerProducer;
+  int64_t consumed = 0;
+  while (consumed < total)
+  {
+    consumed += queue.drain();
+  }
+  for (auto& t : threads)
+  {
+    t->join();
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  double seconds = std::chrono::duration<double>(end - start).count();
+  printf("%-14s %-8s producers=%2d items=%lld  %.3f s  %.2f M ops/s  sum=%lld\n",
+         name, withPayload ? "string" : "pointer", producers, static_cast<long long>(total), seconds,
+         total / seconds / 1e6, static_cast<long long>(g_sum));
+  return seconds;
+}
+
+int main(int argc, char* argv[])
+{
+  int producers = argc > 1 ? atoi(argv[1]) : 16;
+  int items = argc > 2 ? atoi(argv[2]) : 200000;
+
+  for (int n = 1; n <= producers; n *= 2)
+  {
+    for (bool withPayload : { false, true })
+    {
+      bench<MutexVectorQueue>("mutex+vector", n, items, withPayload);
+      bench<MpscFunctorQueue>("mpsc", n, items, withPayload);
+      bench<MpscTaskQueue>("mpsc+task", n, items, withPayload);
+    }
+  }
+}
@@ -0,0 +1,140 @@
+// Buffer::find / findCRLF / findEOL 的向量实现与 std::search、memchr 的对比
+// 先在随机数据上校验各实现的结果一致，再按行长度测吞吐
+// 用法: test15 [totalMB]
+
+#include "Buffer.h"
+#include "ByteSearch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using muduo::Buffer;
+namespace bs = muduo::ByteSearch;
+
+const char kCRLF[] = "\r\n";
+
+const char* searchCRLF(const char* begin, const char* end)
+{
+  const char* p = std::search(begin, end, kCRLF, kCRLF + 2);
+  return p == end ? nullptr : p;
+}
+
+const char* memchrEOL(const char* begin, const char* end)
+{
+  return static_cast<const char*>(memchr(begin, '\n', end - begin));
+}
+
+// 随机数据里故意放很多单独的 '\r' 和 '\n'，覆盖向量块边界上的各种情况
+bool verify(bs::Impl impl)
+{
+  if (!bs::setImpl(impl))
+  {
+    return true;
+  }
+  srand(1);
+  for (int round = 0; round < 20000; ++round)
+  {
+    std::string data(rand() % 600, 'a');
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+      int r = rand() % 16;
+      data[i] = r == 0 ? '\r' : (r == 1 ? '\n' : static_cast<char>('a' + r));
+    }
+    const char* b = data.data();
+    const char* e = b + data.size();
+    size_t from = data.empty() ? 0 : rand() % data.size();
+    if (bs::findCRLF(b + from, e) != searchCRLF(b + from, e)
+        || bs::findByte(b + from, e, '\n') != memchrEOL(b + from, e))
+    {
+      printf("%s: mismatch at round %d size %zu from %zu\n",
+             bs::implName(impl), round, data.size(), from);
+      return false;
+    }
+  }
+  return true;
+}
+
+// 模拟增量解析：buf 中是 lineLen 长的行，逐行查找分隔符并取走
+template<typename Find>
+double bench(const char* name, size_t totalBytes, size_t lineLen,
+             Find find, size_t delimLen)
+{
+  std::string line(lineLen - 2, 'x');
+  line += kCRLF;
+  Buffer buf;
+  buf.reserve(totalBytes);
+  while (buf.readableBytes() + line.size() <= totalBytes)
+  {
+    buf.append(line);
+  }
+  const size_t bytes = buf.readableBytes();
+
+  // 取多轮中最快的一次，减少机器上其他负载带来的抖动
+  const int kRounds = 5;
+  size_t lines = 0;
+  double seconds = 1e9;
+  for (int round = 0; round < kRounds; ++round)
+  {
+    lines = 0;
+    auto start = std::chrono::steady_clock::now();
+    const char* p = buf.peek();
+    const char* end = buf.beginWrite();
+    while (const char* delim = find(p, end))
+    {
+      p = delim + delimLen;
+      ++lines;
+    }
+    auto finish = std::chrono::steady_clock::now();
+    seconds = std::min(seconds, std::chrono::duration<double>(finish - start).count());
+  }
+  printf("%-12s line=%6zu  lines=%8zu  %8.2f MB/s\n",
+         name, lineLen, lines, bytes / seconds / 1e6);
+  return seconds;
+}
+
+int main(int argc, char* argv[])
+{
+  size_t total = (argc > 1 ? atoi(argv[1]) : 64) * 1024 * 1024;
+
+  printf("default: %s\n", bs::implName(bs::currentImpl()));
+  const bs::Impl impls[] = { bs::kScalar, bs::kSse2, bs::kAvx2 };
+  for (bs::Impl impl : impls)
+  {
+    if (!verify(impl))
+    {
+      return 1;
+    }
+  }
+
+  // 增量解析：第一次没找到完整行，下次从上次扫描的位置继续
+  bs::setImpl(bs::kScalar);
+  Buffer buf;
+  buf.append("GET / HTTP/1.1\r");
+  size_t scanned = 0;
+  if (buf.findCRLF(scanned) != nullptr)
+  {
+    return 1;
+  }
+  scanned = buf.readableBytes() - 1;
+  buf.append("\nHost: x\r\n");
+  const char* crlf = buf.findCRLF(scanned);
+  printf("incremental: first line %zu bytes\n", crlf ? crlf - buf.peek() : 0);
+
+  const size_t lineLens[] = { 16, 80, 1024, 64 * 1024 };
+  for (size_t lineLen : lineLens)
+  {
+    bench("std::search", total, lineLen, searchCRLF, 2);
+    bench("memchr", total, lineLen, memchrEOL, 1);
+    for (bs::Impl impl : impls)
+    {
+      if (bs::setImpl(impl))
+      {
+        bench(bs::implName(impl), total, lineLen, bs::findCRLF, 2);
+      }
+    }
+  }
+}
@@ -0,0 +1,106 @@
+// Buffer 扩容策略的基准：流式追加和取走
+// setMaxGrowth(0) 相当于原来的按需精确扩容，与默认的翻倍扩容对比
+// 用法: test16 [totalMB]
+
+#include "Buffer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <utility>
+
+using muduo::Buffer;
+
+typedef void (*Workload)(Buffer* buf, size_t totalBytes, size_t chunk);
+
+// 只追加，最后一次取走：例如把整个响应攒在一个 Buffer 里
+void appendOnly(Buffer* buf, size_t totalBytes, size_t chunk)
+{
+  std::string data(chunk, 'x');
+  for (size_t n = 0; n < totalBytes; n += chunk)
+  {
+    buf->append(data);
+  }
+  buf->retrieveAll();
+}
+
+// 追加之后马上取走一部分，消费者落后生产者：例如解析跟不上接收的输入缓冲区
+void laggingConsumer(Buffer* buf, size_t totalBytes, size_t chunk)
+{
+  std::string data(chunk, 'x');
+  for (size_t n = 0; n < totalBytes; n += chunk)
+  {
+    buf->append(data);
+    buf->retrieve(std::min(buf->readableBytes(), chunk * 3 / 4));
+  }
+  buf->retrieveAll();
+}
+
+// 追加之后取走完整的消息，只留下半条：例如解析速度跟得上的输入缓冲区
+void drainToTail(Buffer* buf, size_t totalBytes, size_t chunk)
+{
+  std::string data(chunk, 'x');
+  for (size_t n = 0; n < totalBytes; n += chunk)
+  {
+    buf->append(data);
+    buf->retrieve(buf->readableBytes() - chunk / 2);
+  }
+  buf->retrieveAll();
+}
+
+void bench(const char* name, Workload workload, size_t totalBytes,
+           size_t chunk, size_t maxGrowth)
+{
+  Buffer buf;
+  buf.setMaxGrowth(maxGrowth);
+  auto start = std::chrono::steady_clock::now();
+  workload(&buf, totalBytes, chunk);
+  auto finish = std::chrono::steady_clock::now();
+
+  double seconds = std::chrono::duration<double>(finish - start).count();
+  printf("%-16s chunk=%5zu %-9s %8.3f s  %9.2f MB/s  capacity=%zu\n",
+         name, chunk, maxGrowth == 0 ? "exact" : "geometric", seconds,
+         totalBytes / seconds / 1e6, buf.capacity());
+}
+
+int main(int argc, char* argv[])
+{
+  size_t total = (argc > 1 ? atoi(argv[1]) : 16) * 1024 * 1024;
+
+  Buffer fresh;
+  if (fresh.readableBytes() != 0)
+  {
+    printf("new Buffer has %zu readable bytes\n", fresh.readableBytes());
+    return 1;
+  }
+
+  // 复制或移动得到的空缓冲区没有内存，retrieveAll 之后仍然可以正常追加
+  Buffer a;
+  a.append("x", 1);
+  a.retrieveAll();
+  Buffer b(a);
+  b.retrieveAll();
+  b.append("y", 1);
+  Buffer c(std::move(a));
+  a.retrieveAll();
+  a.append("z", 1);
+  if (b.readableBytes() != 1 || *b.peek() != 'y' || a.readableBytes() != 1 || *a.peek() != 'z')
+  {
+    printf("append after copying or moving an empty Buffer failed\n");
+    return 1;
+  }
+
+  const size_t chunks[] = { 64, 1024, 16 * 1024 };
+  for (size_t chunk : chunks)
+  {
+    // 精确扩容在追加场景下是平方复杂度，数据量缩小一些
+    size_t exactTotal = total / 16;
+    bench("appendOnly", appendOnly, exactTotal, chunk, 0);
+    bench("appendOnly", appendOnly, exactTotal, chunk, Buffer::kDefaultMaxGrowth);
+    bench("laggingConsumer", laggingConsumer, exactTotal, chunk, 0);
+    bench("laggingConsumer", laggingConsumer, exactTotal, chunk, Buffer::kDefaultMaxGrowth);
+    bench("drainToTail", drainToTail, total, chunk, 0);
+    bench("drainToTail", drainToTail, total, chunk, Buffer::kDefaultMaxGrowth);
+  }
+}
@@ -0,0 +1,212 @@
+#include "CpuAffinity.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <set>
+#include <utility>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace muduo
+{
+namespace CpuAffinity
+{
+
+namespace
+{
+
+#ifdef __linux__
+// 读取 /sys/devices/system/cpu/cpuN/<file> 中的整数，失败返回 -1
+int readCpuAttr(int cpu, const char* file)
+{
+  char path[128];
+  snprintf(path, sizeof path, "/sys/devices/system/cpu/cpu%d/%s", cpu, file);
+  FILE* fp = ::fopen(path, "r");
+  if (fp == NULL)
+  {
+    return -1;
+  }
+  int value = -1;
+  if (::fscanf(fp, "%d", &value) != 1)
+  {
+    value = -1;
+  }
+  ::fclose(fp);
+  return value;
+}
+
+CpuSet allowedCpus()
+{
+  CpuSet cpus;
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  if (::sched_getaffinity(0, sizeof mask, &mask) == 0)
+  {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    {
+      if (CPU_ISSET(cpu, &mask))
+      {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+  return cpus;
+}
+#endif
+
+// 按 NUMA 节点轮流取 CPU 追加到 out
+void interleaveByNode(const std::map<int, CpuSet>& byNode, CpuSet* out)
+{
+  size_t depth = 0;
+  bool more = true;
+  while (more)
+  {
+    more = false;
+    for (std::map<int, CpuSet>::const_iterator it = byNode.begin();
+         it != byNode.end(); ++it)
+    {
+      if (depth < it->second.size())
+      {
+        out->push_back(it->second[depth]);
+        more = true;
+      }
+    }
+    ++depth;
+  }
+}
+
+}
+
+CpuSet spreadCpus()
+{
+  CpuSet result;
+#ifdef __linux__
+  std::set<std::pair<int, int> > seenCores;  // (package, core)
+  std::map<int, CpuSet> primary;   // node -> 每个物理核的第一个逻辑 CPU
+  std::map<int, CpuSet> siblings;  // node -> 超线程兄弟
+  CpuSet cpus = allowedCpus();
+  for (size_t i = 0; i < cpus.size(); ++i)
+  {
+    int cpu = cpus[i];
+    int package = readCpuAttr(cpu, "topology/physical_package_id");
+    int core = readCpuAttr(cpu, "topology/core_id");
+    // 没有 NUMA 信息的机器视为只有节点 0
+    int node = std::max(numaNodeOfCpu(cpu), 0);
+    // 拓扑信息不可用时把每个 CPU 都当作独立的物理核
+    std::pair<int, int> key = (core < 0) ? std::make_pair(-1, cpu)
+                                         : std::make_pair(package, core);
+    if (seenCores.insert(key).second)
+    {
+      primary[node].push_back(cpu);
+    }
+    else
+    {
+      siblings[node].push_back(cpu);
+    }
+  }
+  interleaveByNode(primary, &result);
+  interleaveByNode(siblings, &result);
+#endif
+  return result;
+}
+
+std::vector<CpuSet> spreadAcrossCores(int numThreads)
+{
+  std::vector<CpuSet> sets;
+  CpuSet cpus = spreadCpus();
+  if (cpus.empty())
+  {
+    return sets;
+  }
+  for (int i = 0; i < numThreads; ++i)
+  {
+    sets.push_back(CpuSet(1, cpus[i % cpus.size()]));
+  }
+  return sets;
+}
+
+bool bindCurrentThread(const CpuSet& cpus)
+{
+  if (cpus.empty())
+  {
+    return true;
+  }
+#ifdef __linux__
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  for (size_t i = 0; i < cpus.size(); ++i)
+  {
+    if (cpus[i] >= 0 && cpus[i] < CPU_SETSIZE)
+    {
+      CPU_SET(cpus[i], &mask);
+    }
+  }
+  return ::sched_setaffinity(0, sizeof mask, &mask) == 0;
+#else
+  return false;
+#endif
+}
+
+int numaNodeOfCpu(int cpu)
+{
+#ifdef __linux__
+  char path[64];
+  snprintf(path, sizeof path, "/sys/devices/system/cpu/cpu%d", cpu);
+  DIR* dir = ::opendir(path);
+  if (dir == NULL)
+  {
+    return -1;
+  }
+  int node = -1;
+  while (struct dirent* entry = ::readdir(dir))
+  {
+    // 目录下有一个指向所属节点的 nodeN 链接
+    if (::strncmp(entry->d_name, "node", 4) == 0
+        && entry->d_name[4] >= '0' && entry->d_name[4] <= '9')
+    {
+      node = ::atoi(entry->d_name + 4);
+      break;
+    }
+  }
+  ::closedir(dir);
+  return node;
+#else
+  (void)cpu;
+  return -1;
+#endif
+}
+
+int currentCpu()
+{
+#ifdef __linux__
+  unsigned cpu = 0;
+  if (::syscall(SYS_getcpu, &cpu, NULL, NULL) == 0)
+  {
+    return static_cast<int>(cpu);
+  }
+#endif
+  return -1;
+}
+
+int currentNumaNode()
+{
+#ifdef __linux__
+  unsigned node = 0;
+  if (::syscall(SYS_getcpu, NULL, &node, NULL) == 0)
+  {
+    return static_cast<int>(node);
+  }
+#endif
+  return -1;
+}
+
+}
+}
@@ -0,0 +1,40 @@
+#ifndef CPUAFFINITY_H
+#define CPUAFFINITY_H
+
+#include <vector>
+
+namespace muduo
+{
+
+///
+/// CPU 拓扑与绑核工具，只在 Linux 上有实际效果，其他平台上都是空操作
+/// CPU 编号与 sched_setaffinity / /sys/devices/system/cpu/cpuN 一致
+///
+namespace CpuAffinity
+{
+
+typedef std::vector<int> CpuSet;
+
+// 当前进程允许使用的 CPU，先列出每个物理核的第一个逻辑 CPU，
+// 再列出超线程兄弟，并按 NUMA 节点交错，依次取用即可把线程铺满物理核
+CpuSet spreadCpus();
+
+// 把 spreadCpus() 依次分给 numThreads 个线程，每个线程绑一个 CPU；
+// 线程数多于 CPU 数时循环使用
+std::vector<CpuSet> spreadAcrossCores(int numThreads);
+
+// 把调用线程绑定到 cpus，失败返回 false(cpus 为空时不做任何事并返回 true)
+bool bindCurrentThread(const CpuSet& cpus);
+
+// cpu 所在的 NUMA 节点，无法确定时返回 -1
+int numaNodeOfCpu(int cpu);
+
+// 调用线程当前运行在哪个 CPU/NUMA 节点上；线程未绑核时只是一个瞬时值
+int currentCpu();
+int currentNumaNode();
+
+}
+
+}
+
+#endif //CPUAFFINITY_H
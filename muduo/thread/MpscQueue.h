@@ -0,0 +1,238 @@
+#ifndef MPSCQUEUE_H
+#define MPSCQUEUE_H
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace muduo
+{
+
+///
+/// 无锁多生产者单消费者队列，采用 Dmitry Vyukov 的侵入式 MPSC 算法
+/// push 可以在任意线程调用，只需一次原子交换(wait-free)
+/// pop/consume/empty 只能由唯一的消费者线程调用
+///
+/// 节点不随元素分配和释放：每个队列有自己的无锁空闲栈，消费者把用完的节点整串压回，
+/// 生产者从中弹出一个节点。空闲栈的栈顶带一个修改计数，防止 ABA；
+/// 节点只在队列析构时释放，所以读到已被别人弹出的节点也是安全的
+///
+template<typename T>
+class MpscQueue
+{
+public:
+  MpscQueue()
+    : head_(&stub_),
+      tail_(&stub_),
+      freeHead_(0)
+  {
+  }
+
+  ~MpscQueue()
+  {
+    while (Node* node = popNode())
+    {
+      delete node;
+    }
+    Node* node = nodeOf(freeHead_.load(std::memory_order_acquire));
+    while (node != nullptr)
+    {
+      Node* next = node->next.load(std::memory_order_relaxed);
+      delete node;
+      node = next;
+    }
+  }
+
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+
+  // 入队，线程安全
+  void push(T&& value)
+  {
+    pushNode(allocateNode(std::move(value)));
+  }
+
+  void push(const T& value)
+  {
+    T copy(value);
+    pushNode(allocateNode(std::move(copy)));
+  }
+
+  // 出队，队列为空(或生产者正在入队的中间状态)时返回 false
+  bool pop(T* value)
+  {
+    Node* node = popNode();
+    if (node == nullptr)
+    {
+      return false;
+    }
+    *value = std::move(node->value);
+    node->value = T();
+    releaseNodes(node, node);
+    return true;
+  }
+
+  // 依次对调用时已在队列中的元素执行 func，至多 maxItems 个
+  // 处理过程中新入队的元素留给下一次调用，返回处理的个数
+  template<typename Func>
+  size_t consume(Func&& func, size_t maxItems)
+  {
+    // 入口处的队尾就是本次的边界。队尾是 stub 时(上一次取走最后一个元素后放回的)，
+    // 要处理的是 stub 之前的元素，tail_ 走到 stub 即止；tail_ 已经是 stub 说明队列为空
+    Node* last = head_.load(std::memory_order_acquire);
+    const bool lastIsStub = (last == &stub_);
+    Node* freeFirst = nullptr;
+    Node* freeLast = nullptr;
+    size_t n = 0;
+    while (n < maxItems)
+    {
+      if (lastIsStub && tail_ == &stub_)
+      {
+        break;
+      }
+      Node* node = popNode();
+      if (node == nullptr)
+      {
+        break;
+      }
+      ++n;
+      func(node->value);
+      node->value = T();  // 立即释放元素持有的资源，节点留待复用
+      node->next.store(freeFirst, std::memory_order_relaxed);
+      freeFirst = node;
+      if (freeLast == nullptr)
+      {
+        freeLast = node;
+      }
+      if (node == last)
+      {
+        break;
+      }
+    }
+    if (freeFirst != nullptr)
+    {
+      releaseNodes(freeFirst, freeLast);
+    }
+    return n;
+  }
+
+  // 队列是否为空，生产者正在入队时可能短暂地返回 true
+  bool empty() const
+  {
+    return tail_ == &stub_ && stub_.next.load(std::memory_order_acquire) == nullptr;
+  }
+
+private:
+  struct Node
+  {
+    Node() : next(nullptr), value() {}
+    explicit Node(T&& v) : next(nullptr), value(std::move(v)) {}
+
+    std::atomic<Node*> next;
+    T value;
+  };
+
+  // 空闲栈栈顶的高 16 位是修改计数，低 48 位是节点指针(x86-64/AArch64 用户态地址不超过 48 位)
+  static_assert(sizeof(uintptr_t) == 8, "MpscQueue needs 64-bit pointers");
+  static const int kTagShift = 48;
+  static const uintptr_t kPointerMask = (static_cast<uintptr_t>(1) << kTagShift) - 1;
+
+  static Node* nodeOf(uintptr_t top)
+  {
+    return reinterpret_cast<Node*>(top & kPointerMask);
+  }
+
+  static uintptr_t makeTop(Node* node, uintptr_t oldTop)
+  {
+    uintptr_t ptr = reinterpret_cast<uintptr_t>(node);
+    assert((ptr & ~kPointerMask) == 0);
+    return ptr | ((oldTop & ~kPointerMask) + (static_cast<uintptr_t>(1) << kTagShift));
+  }
+
+  // 生产者调用：优先从空闲栈弹出一个节点，栈空时才分配
+  Node* allocateNode(T&& value)
+  {
+    uintptr_t top = freeHead_.load(std::memory_order_acquire);
+    Node* node;
+    while ((node = nodeOf(top)) != nullptr)
+    {
+      // node 可能已被别的生产者弹出，这时读到的 next 没有意义，但计数变了，CAS 一定失败
+      Node* next = node->next.load(std::memory_order_relaxed);
+      if (freeHead_.compare_exchange_weak(top, makeTop(next, top),
+                                          std::memory_order_acquire,
+                                          std::memory_order_acquire))
+      {
+        node->value = std::move(value);
+        return node;
+      }
+    }
+    return new Node(std::move(value));
+  }
+
+  // 消费者调用：把 first 到 last 这一串(已通过 next 串好)压回空闲栈
+  void releaseNodes(Node* first, Node* last)
+  {
+    uintptr_t top = freeHead_.load(std::memory_order_relaxed);
+    do
+    {
+      last->next.store(nodeOf(top), std::memory_order_relaxed);
+    } while (!freeHead_.compare_exchange_weak(top, makeTop(first, top),
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed));
+  }
+
+  void pushNode(Node* node)
+  {
+    node->next.store(nullptr, std::memory_order_relaxed);
+    Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+    // 在这两步之间，消费者看到的链表是断开的，popNode 会把它当作暂时为空
+    prev->next.store(node, std::memory_order_release);
+  }
+
+  Node* popNode()
+  {
+    Node* tail = tail_;
+    Node* next = tail->next.load(std::memory_order_acquire);
+    if (tail == &stub_)
+    {
+      if (next == nullptr)
+      {
+        return nullptr;
+      }
+      tail_ = next;
+      tail = next;
+      next = next->next.load(std::memory_order_acquire);
+    }
+    if (next != nullptr)
+    {
+      tail_ = next;
+      return tail;
+    }
+    if (tail != head_.load(std::memory_order_acquire))
+    {
+      return nullptr;  // 生产者入队尚未完成
+    }
+    // 只剩最后一个元素，把 stub 放回队尾后才能取走它
+    pushNode(&stub_);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next != nullptr)
+    {
+      tail_ = next;
+      return tail;
+    }
+    return nullptr;
+  }
+
+  std::atomic<Node*> head_;  // 生产者在这里入队
+  char pad_[64 - sizeof(std::atomic<Node*>)];  // 避免与消费者端伪共享
+  Node* tail_;               // 消费者在这里出队
+  Node stub_;
+  char pad2_[64];            // 空闲栈由生产者争用，与消费者端分开
+  std::atomic<uintptr_t> freeHead_;  // 空闲栈栈顶：修改计数 | 节点指针
+};
+
+}
+
+#endif //MPSCQUEUE_H